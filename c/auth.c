@@ -3,6 +3,9 @@
 #include "mbedtls/md_internal.h"
 #include "mbedtls/memory_buffer_alloc.h"
 #include "ed25519.h"
+#ifdef CKB_AUTH_BLS12381
+#include "blst.h"
+#endif
 #include "ge.h"
 #include "sc.h"
 
@@ -33,6 +36,9 @@
 // clang-format on
 
 #include "cardano/cardano_lock_inc.h"
+#include "rsa/rsa_verify_inc.h"
+#include "secp256r1/secp256r1_helper.h"
+#include "ed25519_key_cache.h"
 
 // secp256k1 also defines this macros
 #undef CHECK2
@@ -59,6 +65,9 @@
 #define SECP256K1_PUBKEY_SIZE 33
 #define UNCOMPRESSED_SECP256K1_PUBKEY_SIZE 65
 #define SECP256K1_SIGNATURE_SIZE 65
+#define SECP256K1_COMPACT_SIGNATURE_SIZE 64
+#define SECP256K1_PUBKEY_SIGNATURE_SIZE \
+    (SECP256K1_PUBKEY_SIZE + SECP256K1_COMPACT_SIGNATURE_SIZE)
 #define SECP256K1_MESSAGE_SIZE 32
 #define RECID_INDEX 64
 #define SHA256_SIZE 32
@@ -75,6 +84,17 @@
 #define SOLANA_UNWRAPPED_SIGNATURE_SIZE 510
 #define SOLANA_BLOCKHASH_SIZE 32
 #define SOLANA_MESSAGE_HEADER_SIZE 3
+#define SECP256R1_DATA_SIZE (SECP256R1_PUBKEY_SIZE + SECP256R1_SIGNATURE_SIZE)
+#define WEBAUTHN_AUTH_DATA_MIN_SIZE 37
+#define WEBAUTHN_FLAGS_INDEX 32
+#define WEBAUTHN_FLAG_USER_PRESENT 0x01
+// base64url of a 32-byte message, without padding
+#define WEBAUTHN_CHALLENGE_SIZE 43
+#define BLS12381_PUBKEY_SIZE 48
+#define BLS12381_SIGNATURE_SIZE 96
+#define BLS12381_DATA_SIZE (BLS12381_PUBKEY_SIZE + BLS12381_SIGNATURE_SIZE)
+#define COMPOSITE_HEADER_SIZE 2
+#define COMPOSITE_SIGNATURE_HEADER_SIZE 3
 
 enum AuthErrorCodeType {
     ERROR_NOT_IMPLEMENTED = 100,
@@ -90,6 +110,8 @@ enum AuthErrorCodeType {
     ERROR_SPAWN_INVALID_PUBKEY,
     // schnorr
     ERROR_SCHNORR,
+    // bls12-381
+    ERROR_BLS12381,
 };
 
 typedef int (*validate_signature_t)(void *prefilled_data, const uint8_t *sig,
@@ -121,12 +143,61 @@ exit:
     return err;
 }
 
+// Set while a composite auth is verified, so that its secp256k1 based entries
+// share one context instead of loading the 1 MB table for every signature.
+static secp256k1_context *g_shared_secp256k1_context = NULL;
+
+// Size of the data buffer callers pass to _secp256k1_context. The buffer has
+// to outlive the call, so it stays in the caller's frame, as a variable
+// length array: within a composite auth, whose frame already holds the
+// table, it shrinks to 1 byte instead of a second 1 MB on the stack.
+#define SECP256K1_DATA_BUFFER_SIZE \
+    (g_shared_secp256k1_context != NULL ? 1 : CKB_SECP256K1_DATA_SIZE)
+
+// context and data are only used when there is no shared context.
+static int _secp256k1_context(secp256k1_context *context, void *data,
+                              secp256k1_context **out) {
+    if (g_shared_secp256k1_context != NULL) {
+        *out = g_shared_secp256k1_context;
+        return 0;
+    }
+    int ret = ckb_secp256k1_custom_verify_only_initialize(context, data);
+    if (ret != 0) {
+        return ret;
+    }
+    *out = context;
+    return 0;
+}
+
+// EIP-2098 compact signature: r(32) | s(32) with the recovery id in the top
+// bit of s. EIP-2098 requires a low s (s <= n/2 < 2^255), which leaves that
+// bit free. Low s isn't enforced here though: secp256k1_ecdsa_recover accepts
+// any s < n, so a high s below 2^255 is recovered as well.
+// Expands it to r | s | recovery id, the layout secp256k1 parses.
+static void _expand_compact_signature(const uint8_t *compact, uint8_t *sig) {
+    memcpy(sig, compact, SECP256K1_COMPACT_SIGNATURE_SIZE);
+    sig[32] &= 0x7f;
+    sig[RECID_INDEX] = compact[32] >> 7;
+}
+
+static bool _is_secp256k1_signature_size(size_t sig_len) {
+    return sig_len == SECP256K1_SIGNATURE_SIZE ||
+           sig_len == SECP256K1_COMPACT_SIGNATURE_SIZE ||
+           sig_len == SECP256K1_PUBKEY_SIGNATURE_SIZE;
+}
+
 static int _recover_secp256k1_pubkey(const uint8_t *sig, size_t sig_len,
                                      const uint8_t *msg, size_t msg_len,
                                      uint8_t *out_pubkey,
                                      size_t *out_pubkey_size, bool compressed) {
     int ret = 0;
 
+    uint8_t expanded[SECP256K1_SIGNATURE_SIZE];
+    if (sig_len == SECP256K1_COMPACT_SIGNATURE_SIZE) {
+        _expand_compact_signature(sig, expanded);
+        sig = expanded;
+        sig_len = SECP256K1_SIGNATURE_SIZE;
+    }
     if (sig_len != SECP256K1_SIGNATURE_SIZE) {
         return ERROR_INVALID_ARG;
     }
@@ -136,21 +207,22 @@ static int _recover_secp256k1_pubkey(const uint8_t *sig, size_t sig_len,
 
     /* Load signature */
     secp256k1_context context;
-    uint8_t secp_data[CKB_SECP256K1_DATA_SIZE];
-    ret = ckb_secp256k1_custom_verify_only_initialize(&context, secp_data);
+    uint8_t secp_data[SECP256K1_DATA_BUFFER_SIZE];
+    secp256k1_context *ctx = NULL;
+    ret = _secp256k1_context(&context, secp_data, &ctx);
     if (ret != 0) {
         return ret;
     }
 
     secp256k1_ecdsa_recoverable_signature signature;
     if (secp256k1_ecdsa_recoverable_signature_parse_compact(
-            &context, &signature, sig, sig[RECID_INDEX]) == 0) {
+            ctx, &signature, sig, sig[RECID_INDEX]) == 0) {
         return ERROR_WRONG_STATE;
     }
 
     /* Recover pubkey */
     secp256k1_pubkey pubkey;
-    if (secp256k1_ecdsa_recover(&context, &pubkey, &signature, msg) != 1) {
+    if (secp256k1_ecdsa_recover(ctx, &pubkey, &signature, msg) != 1) {
         return ERROR_WRONG_STATE;
     }
 
@@ -162,7 +234,7 @@ static int _recover_secp256k1_pubkey(const uint8_t *sig, size_t sig_len,
         *out_pubkey_size = UNCOMPRESSED_SECP256K1_PUBKEY_SIZE;
         flag = SECP256K1_EC_UNCOMPRESSED;
     }
-    if (secp256k1_ec_pubkey_serialize(&context, out_pubkey, out_pubkey_size,
+    if (secp256k1_ec_pubkey_serialize(ctx, out_pubkey, out_pubkey_size,
                                       &pubkey, flag) != 1) {
         return ERROR_WRONG_STATE;
     }
@@ -177,21 +249,33 @@ static int _recover_secp256k1_pubkey_btc(const uint8_t *sig, size_t sig_len,
     (void)compressed;
     int ret = 0;
 
-    if (sig_len != SECP256K1_SIGNATURE_SIZE) {
-        return ERROR_INVALID_ARG;
-    }
     if (msg_len != SECP256K1_MESSAGE_SIZE) {
         return ERROR_INVALID_ARG;
     }
 
     // change 1
-    int recid = (sig[0] - 27) & 3;
-    bool comp = ((sig[0] - 27) & 4) != 0;
+    int recid = 0;
+    bool comp = true;
+    const uint8_t *rs = sig + 1;
+    uint8_t expanded[SECP256K1_SIGNATURE_SIZE];
+    if (sig_len == SECP256K1_COMPACT_SIGNATURE_SIZE) {
+        // There is no header byte to tell the key is compressed, compact
+        // signatures are only accepted for compressed keys.
+        _expand_compact_signature(sig, expanded);
+        recid = expanded[RECID_INDEX];
+        rs = expanded;
+    } else if (sig_len == SECP256K1_SIGNATURE_SIZE) {
+        recid = (sig[0] - 27) & 3;
+        comp = ((sig[0] - 27) & 4) != 0;
+    } else {
+        return ERROR_INVALID_ARG;
+    }
 
     /* Load signature */
     secp256k1_context context;
-    uint8_t secp_data[CKB_SECP256K1_DATA_SIZE];
-    ret = ckb_secp256k1_custom_verify_only_initialize(&context, secp_data);
+    uint8_t secp_data[SECP256K1_DATA_BUFFER_SIZE];
+    secp256k1_context *ctx = NULL;
+    ret = _secp256k1_context(&context, secp_data, &ctx);
     if (ret != 0) {
         return ret;
     }
@@ -199,13 +283,13 @@ static int _recover_secp256k1_pubkey_btc(const uint8_t *sig, size_t sig_len,
     secp256k1_ecdsa_recoverable_signature signature;
     // change 2,3
     if (secp256k1_ecdsa_recoverable_signature_parse_compact(
-            &context, &signature, sig + 1, recid) == 0) {
+            ctx, &signature, rs, recid) == 0) {
         return ERROR_WRONG_STATE;
     }
 
     /* Recover pubkey */
     secp256k1_pubkey pubkey;
-    if (secp256k1_ecdsa_recover(&context, &pubkey, &signature, msg) != 1) {
+    if (secp256k1_ecdsa_recover(ctx, &pubkey, &signature, msg) != 1) {
         return ERROR_WRONG_STATE;
     }
 
@@ -218,13 +302,143 @@ static int _recover_secp256k1_pubkey_btc(const uint8_t *sig, size_t sig_len,
         flag = SECP256K1_EC_UNCOMPRESSED;
     }
     // change 4
-    if (secp256k1_ec_pubkey_serialize(&context, out_pubkey, out_pubkey_size,
+    if (secp256k1_ec_pubkey_serialize(ctx, out_pubkey, out_pubkey_size,
                                       &pubkey, flag) != 1) {
         return ERROR_WRONG_STATE;
     }
     return ret;
 }
 
+// For validators that carry the public key in the signature: hash it before
+// any signature math. verify() passes the expected pubkey hash as
+// prefilled_data, so a mismatched witness is rejected after one blake2b.
+static int _check_pubkey_hash(void *prefilled_data, const uint8_t *pubkey,
+                              size_t pubkey_len, uint8_t *output,
+                              size_t *output_len) {
+    uint8_t temp[BLAKE2B_BLOCK_SIZE] = {0};
+    blake2b_state blake2b_ctx;
+    blake2b_init(&blake2b_ctx, BLAKE2B_BLOCK_SIZE);
+    blake2b_update(&blake2b_ctx, pubkey, pubkey_len);
+    blake2b_final(&blake2b_ctx, temp, BLAKE2B_BLOCK_SIZE);
+
+    memcpy(output, temp, BLAKE160_SIZE);
+    *output_len = BLAKE160_SIZE;
+    if (prefilled_data != NULL &&
+        memcmp(prefilled_data, temp, BLAKE160_SIZE) != 0) {
+        return ERROR_MISMATCHED;
+    }
+    return 0;
+}
+
+typedef int (*hash_secp256k1_pubkey_t)(const uint8_t *pubkey,
+                                       size_t pubkey_len, uint8_t *output);
+
+static int _blake160_pubkey(const uint8_t *pubkey, size_t pubkey_len,
+                            uint8_t *output) {
+    uint8_t temp[BLAKE2B_BLOCK_SIZE];
+    blake2b_state ctx;
+    blake2b_init(&ctx, BLAKE2B_BLOCK_SIZE);
+    blake2b_update(&ctx, pubkey, pubkey_len);
+    blake2b_final(&ctx, temp, BLAKE2B_BLOCK_SIZE);
+    memcpy(output, temp, BLAKE160_SIZE);
+    return 0;
+}
+
+// last 20 bytes of keccak256 of the uncompressed pubkey without its prefix
+static int _eth_pubkey_hash(const uint8_t *pubkey, size_t pubkey_len,
+                            uint8_t *output) {
+    uint8_t temp[32];
+    keccak256(&pubkey[1], pubkey_len - 1, temp);
+    memcpy(output, &temp[12], BLAKE160_SIZE);
+    return 0;
+}
+
+// ripemd160(sha256(pubkey))
+static int _hash160_pubkey(const uint8_t *pubkey, size_t pubkey_len,
+                           uint8_t *output) {
+    int err = 0;
+    unsigned char temp[SHA256_SIZE];
+    err = md_string(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), pubkey,
+                    pubkey_len, temp);
+    CHECK(err);
+    err = md_string(mbedtls_md_info_from_type(MBEDTLS_MD_RIPEMD160), temp,
+                    SHA256_SIZE, temp);
+    CHECK(err);
+    memcpy(output, temp, BLAKE160_SIZE);
+
+exit:
+    return err;
+}
+
+// Signature carrying its public key: compressed pubkey(33) | r(32) | s(32).
+// The key is hashed and checked against prefilled_data first, then the
+// signature is verified against it. Recovery has to lift r to a point (a
+// square root) and serialize the key on top of the same double
+// multiplication; here only parsing the compressed key takes a square root.
+// With `compressed` false, the key is hashed in its uncompressed form, which
+// needs it parsed before the check.
+static int _verify_secp256k1_pubkey_signature(
+    void *prefilled_data, const uint8_t *sig, size_t sig_len,
+    const uint8_t *msg, size_t msg_len, bool compressed,
+    hash_secp256k1_pubkey_t hash, uint8_t *output, size_t *output_len) {
+    int ret = 0;
+    if (sig_len != SECP256K1_PUBKEY_SIGNATURE_SIZE ||
+        msg_len != SECP256K1_MESSAGE_SIZE) {
+        return ERROR_INVALID_ARG;
+    }
+    if (compressed) {
+        ret = hash(sig, SECP256K1_PUBKEY_SIZE, output);
+        if (ret != 0) return ret;
+        *output_len = BLAKE160_SIZE;
+        if (prefilled_data != NULL &&
+            memcmp(prefilled_data, output, BLAKE160_SIZE) != 0) {
+            return ERROR_MISMATCHED;
+        }
+    }
+
+    secp256k1_context context;
+    uint8_t secp_data[SECP256K1_DATA_BUFFER_SIZE];
+    secp256k1_context *ctx = NULL;
+    ret = _secp256k1_context(&context, secp_data, &ctx);
+    if (ret != 0) {
+        return ret;
+    }
+
+    secp256k1_pubkey pubkey;
+    if (secp256k1_ec_pubkey_parse(ctx, &pubkey, sig, SECP256K1_PUBKEY_SIZE) !=
+        1) {
+        return ERROR_WRONG_STATE;
+    }
+    if (!compressed) {
+        uint8_t serialized[UNCOMPRESSED_SECP256K1_PUBKEY_SIZE];
+        size_t serialized_len = UNCOMPRESSED_SECP256K1_PUBKEY_SIZE;
+        if (secp256k1_ec_pubkey_serialize(ctx, serialized, &serialized_len,
+                                          &pubkey,
+                                          SECP256K1_EC_UNCOMPRESSED) != 1) {
+            return ERROR_WRONG_STATE;
+        }
+        ret = hash(serialized, serialized_len, output);
+        if (ret != 0) return ret;
+        *output_len = BLAKE160_SIZE;
+        if (prefilled_data != NULL &&
+            memcmp(prefilled_data, output, BLAKE160_SIZE) != 0) {
+            return ERROR_MISMATCHED;
+        }
+    }
+
+    // Parsing doesn't normalize s and verification rejects a high s, so
+    // the witness isn't malleable.
+    secp256k1_ecdsa_signature signature;
+    if (secp256k1_ecdsa_signature_parse_compact(
+            ctx, &signature, sig + SECP256K1_PUBKEY_SIZE) != 1) {
+        return ERROR_WRONG_STATE;
+    }
+    if (secp256k1_ecdsa_verify(ctx, &signature, msg, &pubkey) != 1) {
+        return ERROR_WRONG_STATE;
+    }
+    return ret;
+}
+
 int validate_signature_ckb(void *prefilled_data, const uint8_t *sig,
                            size_t sig_len, const uint8_t *msg, size_t msg_len,
                            uint8_t *output, size_t *output_len) {
@@ -232,18 +446,18 @@ int validate_signature_ckb(void *prefilled_data, const uint8_t *sig,
     if (*output_len < BLAKE160_SIZE) {
         return ERROR_INVALID_ARG;
     }
+    if (sig_len == SECP256K1_PUBKEY_SIGNATURE_SIZE) {
+        return _verify_secp256k1_pubkey_signature(
+            prefilled_data, sig, sig_len, msg, msg_len, true, _blake160_pubkey,
+            output, output_len);
+    }
     uint8_t out_pubkey[SECP256K1_PUBKEY_SIZE];
     size_t out_pubkey_size = SECP256K1_PUBKEY_SIZE;
     ret = _recover_secp256k1_pubkey(sig, sig_len, msg, msg_len, out_pubkey,
                                     &out_pubkey_size, true);
     if (ret != 0) return ret;
 
-    blake2b_state ctx;
-    blake2b_init(&ctx, BLAKE2B_BLOCK_SIZE);
-    blake2b_update(&ctx, out_pubkey, out_pubkey_size);
-    blake2b_final(&ctx, out_pubkey, BLAKE2B_BLOCK_SIZE);
-
-    memcpy(output, out_pubkey, BLAKE160_SIZE);
+    _blake160_pubkey(out_pubkey, out_pubkey_size, output);
     *output_len = BLAKE160_SIZE;
 
     return ret;
@@ -256,6 +470,11 @@ int validate_signature_eth(void *prefilled_data, const uint8_t *sig,
     if (*output_len < BLAKE160_SIZE) {
         return SECP256K1_PUBKEY_SIZE;
     }
+    if (sig_len == SECP256K1_PUBKEY_SIGNATURE_SIZE) {
+        return _verify_secp256k1_pubkey_signature(
+            prefilled_data, sig, sig_len, msg, msg_len, false, _eth_pubkey_hash,
+            output, output_len);
+    }
     uint8_t out_pubkey[UNCOMPRESSED_SECP256K1_PUBKEY_SIZE];
     size_t out_pubkey_size = UNCOMPRESSED_SECP256K1_PUBKEY_SIZE;
     ret = _recover_secp256k1_pubkey(sig, sig_len, msg, msg_len, out_pubkey,
@@ -263,12 +482,7 @@ int validate_signature_eth(void *prefilled_data, const uint8_t *sig,
     if (ret != 0) return ret;
 
     // here are the 2 differences than validate_signature_secp256k1
-    SHA3_CTX sha3_ctx;
-    keccak_init(&sha3_ctx);
-    keccak_update(&sha3_ctx, &out_pubkey[1], out_pubkey_size - 1);
-    keccak_final(&sha3_ctx, out_pubkey);
-
-    memcpy(output, &out_pubkey[12], BLAKE160_SIZE);
+    _eth_pubkey_hash(out_pubkey, out_pubkey_size, output);
     *output_len = BLAKE160_SIZE;
 
     return ret;
@@ -281,6 +495,12 @@ int validate_signature_btc(void *prefilled_data, const uint8_t *sig,
     if (*output_len < BLAKE160_SIZE) {
         return SECP256K1_PUBKEY_SIZE;
     }
+    if (sig_len == SECP256K1_PUBKEY_SIGNATURE_SIZE) {
+        // The carried key is compressed, as for compact signatures.
+        return _verify_secp256k1_pubkey_signature(
+            prefilled_data, sig, sig_len, msg, msg_len, true, _hash160_pubkey,
+            output, output_len);
+    }
     uint8_t out_pubkey[UNCOMPRESSED_SECP256K1_PUBKEY_SIZE];
     size_t out_pubkey_size = UNCOMPRESSED_SECP256K1_PUBKEY_SIZE;
     err = _recover_secp256k1_pubkey_btc(sig, sig_len, msg, msg_len, out_pubkey,
@@ -304,6 +524,38 @@ exit:
     return err;
 }
 
+// Parsed x-only keys of this run. Parsing lifts x to a point, a square root,
+// which would otherwise be repeated for every entry signed by the same key.
+#define SCHNORR_KEY_CACHE_SIZE 4
+
+static uint8_t g_schnorr_key_cache_input[SCHNORR_KEY_CACHE_SIZE]
+                                        [SCHNORR_PUBKEY_SIZE];
+static secp256k1_xonly_pubkey g_schnorr_key_cache[SCHNORR_KEY_CACHE_SIZE];
+static size_t g_schnorr_key_cache_count = 0;
+
+static int _schnorr_pubkey_parse(const secp256k1_context *ctx,
+                                 secp256k1_xonly_pubkey *pk,
+                                 const uint8_t *input) {
+    size_t count = g_schnorr_key_cache_count < SCHNORR_KEY_CACHE_SIZE
+                       ? g_schnorr_key_cache_count
+                       : SCHNORR_KEY_CACHE_SIZE;
+    for (size_t i = 0; i < count; i++) {
+        if (memcmp(g_schnorr_key_cache_input[i], input, SCHNORR_PUBKEY_SIZE) ==
+            0) {
+            *pk = g_schnorr_key_cache[i];
+            return 1;
+        }
+    }
+    if (!secp256k1_xonly_pubkey_parse(ctx, pk, input)) {
+        return 0;
+    }
+    size_t slot = g_schnorr_key_cache_count % SCHNORR_KEY_CACHE_SIZE;
+    memcpy(g_schnorr_key_cache_input[slot], input, SCHNORR_PUBKEY_SIZE);
+    g_schnorr_key_cache[slot] = *pk;
+    g_schnorr_key_cache_count++;
+    return 1;
+}
+
 int validate_signature_schnorr(void *prefilled_data, const uint8_t *sig,
                                size_t sig_len, const uint8_t *msg,
                                size_t msg_len, uint8_t *output,
@@ -317,27 +569,23 @@ int validate_signature_schnorr(void *prefilled_data, const uint8_t *sig,
     if (sig_len != SCHNORR_SIGNATURE_SIZE || msg_len != 32) {
         return ERROR_INVALID_ARG;
     }
-    secp256k1_context ctx;
-    uint8_t secp_data[CKB_SECP256K1_DATA_SIZE];
-    err = ckb_secp256k1_custom_verify_only_initialize(&ctx, secp_data);
+    err = _check_pubkey_hash(prefilled_data, sig, SCHNORR_PUBKEY_SIZE, output,
+                             output_len);
+    if (err != 0) return err;
+
+    secp256k1_context context;
+    uint8_t secp_data[SECP256K1_DATA_BUFFER_SIZE];
+    secp256k1_context *ctx = NULL;
+    err = _secp256k1_context(&context, secp_data, &ctx);
     if (err != 0) return err;
 
     secp256k1_xonly_pubkey pk;
-    success = secp256k1_xonly_pubkey_parse(&ctx, &pk, sig);
+    success = _schnorr_pubkey_parse(ctx, &pk, sig);
     if (!success) return ERROR_SCHNORR;
     success =
-        secp256k1_schnorrsig_verify(&ctx, sig + SCHNORR_PUBKEY_SIZE, msg, &pk);
+        secp256k1_schnorrsig_verify(ctx, sig + SCHNORR_PUBKEY_SIZE, msg, &pk);
     if (!success) return ERROR_SCHNORR;
 
-    uint8_t temp[BLAKE2B_BLOCK_SIZE] = {0};
-    blake2b_state blake2b_ctx;
-    blake2b_init(&blake2b_ctx, BLAKE2B_BLOCK_SIZE);
-    blake2b_update(&blake2b_ctx, sig, SCHNORR_PUBKEY_SIZE);
-    blake2b_final(&blake2b_ctx, temp, BLAKE2B_BLOCK_SIZE);
-
-    memcpy(output, temp, BLAKE160_SIZE);
-    *output_len = BLAKE160_SIZE;
-
     return 0;
 }
 
@@ -358,20 +606,15 @@ int validate_signature_cardano(void *prefilled_data, const uint8_t *sig,
     CHECK2(memcmp(msg, cardano_data.ckb_sign_msg, msg_len) == 0,
            ERROR_INVALID_ARG);
 
-    int suc = ed25519_verify(cardano_data.signature, cardano_data.sign_message,
-                             CARDANO_LOCK_SIGNATURE_MESSAGE_SIZE,
-                             cardano_data.public_key);
-    CHECK2(suc == 1, ERROR_WRONG_STATE);
-
-    blake2b_state ctx;
-    uint8_t pubkey_hash[BLAKE2B_BLOCK_SIZE] = {0};
-    blake2b_init(&ctx, BLAKE2B_BLOCK_SIZE);
-    blake2b_update(&ctx, cardano_data.public_key,
-                   sizeof(cardano_data.public_key));
-    blake2b_final(&ctx, pubkey_hash, sizeof(pubkey_hash));
+    err = _check_pubkey_hash(prefilled_data, cardano_data.public_key,
+                             sizeof(cardano_data.public_key), output,
+                             output_len);
+    CHECK(err);
 
-    memcpy(output, pubkey_hash, BLAKE160_SIZE);
-    *output_len = BLAKE160_SIZE;
+    int suc = ed25519_verify_cached(
+        cardano_data.signature, cardano_data.sign_message,
+        CARDANO_LOCK_SIGNATURE_MESSAGE_SIZE, cardano_data.public_key);
+    CHECK2(suc == 1, ERROR_WRONG_STATE);
 exit:
     return err;
 }
@@ -469,7 +712,6 @@ int ed25519_verify_monero(const unsigned char *signature,
                           const unsigned char *message, size_t message_len,
                           const unsigned char *public_key) {
     ge_p2 tmp2;
-    ge_p3 tmp3;
     uint8_t c[32];
     uint8_t comm[32];
     uint8_t *sig_c = (uint8_t *)signature;
@@ -485,10 +727,12 @@ int ed25519_verify_monero(const unsigned char *signature,
     // scalar
     sc_0(zero);
     sc_sub(sig_c_neg, zero, sig_c);
-    if (ge_frombytes_negate_vartime(&tmp3, public_key) != 0) {
+    const ge_cached *pubkey_multiples = ed25519_key_odd_multiples(public_key);
+    if (pubkey_multiples == NULL) {
         return 0;
     }
-    ge_double_scalarmult_vartime(&tmp2, sig_c_neg, &tmp3, sig_r);
+    ed25519_double_scalarmult_cached(&tmp2, sig_c_neg, pubkey_multiples,
+                                     sig_r);
     ge_tobytes(comm, &tmp2);
 
     static const uint8_t infinity[32] = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -518,22 +762,17 @@ int validate_signature_monero(void *prefilled_data, const uint8_t *sig,
     uint8_t *view_pubkey = spend_pubkey + MONERO_PUBKEY_SIZE;
     uint8_t *pubkey = spend_pubkey;
 
+    // TODO: find out the official way of get monero pubkey
+    err = _check_pubkey_hash(prefilled_data, mode_ptr,
+                             1 + MONERO_PUBKEY_SIZE * 2, output, output_len);
+    CHECK(err);
+
     uint8_t hash[MONERO_KECCAK_SIZE];
     get_monero_message_hash(hash, spend_pubkey, view_pubkey, *mode_ptr, msg,
                             msg_len);
 
     int suc = ed25519_verify_monero(sig, hash, sizeof(hash), pubkey);
     CHECK2(suc == 1, ERROR_SPAWN_INVALID_SIG);
-
-    blake2b_state ctx;
-    uint8_t pubkey_hash[BLAKE2B_BLOCK_SIZE] = {0};
-    blake2b_init(&ctx, BLAKE2B_BLOCK_SIZE);
-    // TODO: find out the official way of get monero pubkey
-    blake2b_update(&ctx, mode_ptr, 1 + MONERO_PUBKEY_SIZE * 2);
-    blake2b_final(&ctx, pubkey_hash, sizeof(pubkey_hash));
-
-    memcpy(output, pubkey_hash, BLAKE160_SIZE);
-    *output_len = BLAKE160_SIZE;
 exit:
     return err;
 }
@@ -580,24 +819,299 @@ int validate_signature_solana(void *prefilled_data, const uint8_t *sig,
     const uint8_t *signed_msg_ptr = signature_ptr + SOLANA_SIGNATURE_SIZE + SOLANA_PUBKEY_SIZE;
     size_t signed_msg_len = sig_len - SOLANA_SIGNATURE_SIZE - SOLANA_PUBKEY_SIZE;
 
+    CHECK(_check_pubkey_hash(prefilled_data, pub_key_ptr, SOLANA_PUBKEY_SIZE,
+                             output, output_len));
     CHECK(validate_solana_signed_message(signed_msg_ptr, signed_msg_len, pub_key_ptr, msg));
 
 
-    int suc = ed25519_verify(signature_ptr, signed_msg_ptr, signed_msg_len, pub_key_ptr);
+    int suc = ed25519_verify_cached(signature_ptr, signed_msg_ptr, signed_msg_len, pub_key_ptr);
     CHECK2(suc == 1, ERROR_WRONG_STATE);
+exit:
+    return err;
+}
 
-    blake2b_state ctx;
-    uint8_t pubkey_hash[BLAKE2B_BLOCK_SIZE] = {0};
-    blake2b_init(&ctx, BLAKE2B_BLOCK_SIZE);
-    blake2b_update(&ctx, pub_key_ptr, SOLANA_PUBKEY_SIZE);
-    blake2b_final(&ctx, pubkey_hash, sizeof(pubkey_hash));
+typedef int (*rsa_verify_t)(const RsaInfo *info, const uint8_t *msg,
+                            size_t msg_len);
 
-    memcpy(output, pubkey_hash, BLAKE160_SIZE);
-    *output_len = BLAKE160_SIZE;
+static int _validate_rsa_info(void *prefilled_data, const uint8_t *sig,
+                              size_t sig_len, const uint8_t *msg,
+                              size_t msg_len, uint8_t *output,
+                              size_t *output_len,
+                              rsa_verify_t rsa_verify_func) {
+    int err = 0;
+
+    CHECK2(*output_len >= BLAKE160_SIZE, ERROR_INVALID_ARG);
+    CHECK2(sig_len > RSA_INFO_HEADER_SIZE, ERROR_INVALID_ARG);
+    const RsaInfo *info = (const RsaInfo *)sig;
+    size_t key_bytes = get_rsa_key_bytes(info->key_size);
+    CHECK2(key_bytes > 0, ERROR_INVALID_ARG);
+    CHECK2(sig_len == calculate_rsa_info_length(key_bytes), ERROR_INVALID_ARG);
+
+    // pubkey hash covers the header too, so the padding mode and digest
+    // can't be swapped for the same key.
+    err = _check_pubkey_hash(prefilled_data, sig,
+                             RSA_INFO_HEADER_SIZE + key_bytes, output,
+                             output_len);
+    CHECK(err);
+
+    err = rsa_verify_func(info, msg, msg_len);
+    CHECK(err);
+exit:
+    return err;
+}
+
+int validate_signature_rsa(void *prefilled_data, const uint8_t *sig,
+                           size_t sig_len, const uint8_t *msg, size_t msg_len,
+                           uint8_t *output, size_t *output_len) {
+    return _validate_rsa_info(prefilled_data, sig, sig_len, msg, msg_len,
+                              output, output_len, rsa_verify);
+}
+
+int validate_signature_iso97962(void *prefilled_data, const uint8_t *sig,
+                                size_t sig_len, const uint8_t *msg,
+                                size_t msg_len, uint8_t *output,
+                                size_t *output_len) {
+    return _validate_rsa_info(prefilled_data, sig, sig_len, msg, msg_len,
+                              output, output_len, iso97962_verify);
+}
+
+static int _verify_secp256r1(const uint8_t *pubkey, const uint8_t *sig,
+                             const uint8_t *digest) {
+    uint64_t secp_data[CKB_SECP256R1_DATA_SIZE / sizeof(uint64_t)];
+    int err = ckb_secp256r1_load_data(secp_data);
+    if (err != 0) return err;
+    return secp256r1_verify((const Secp256r1Affine *)secp_data, pubkey, sig,
+                            digest);
+}
+
+// signature: pubkey(x | y) | r | s, msg: SHA256 of the message (see
+// convert_sha256_message)
+int validate_signature_secp256r1(void *prefilled_data, const uint8_t *sig,
+                                 size_t sig_len, const uint8_t *msg,
+                                 size_t msg_len, uint8_t *output,
+                                 size_t *output_len) {
+    int err = 0;
+
+    CHECK2(*output_len >= BLAKE160_SIZE, ERROR_INVALID_ARG);
+    CHECK2(sig_len == SECP256R1_DATA_SIZE, ERROR_INVALID_ARG);
+    CHECK2(msg_len == SECP256R1_DIGEST_SIZE, ERROR_INVALID_ARG);
+
+    err = _check_pubkey_hash(prefilled_data, sig, SECP256R1_PUBKEY_SIZE, output,
+                             output_len);
+    CHECK(err);
+    err = _verify_secp256r1(sig, sig + SECP256R1_PUBKEY_SIZE, msg);
+    CHECK(err);
 exit:
     return err;
 }
 
+static void webauthn_base64url_encode(const uint8_t *in, size_t in_len,
+                                      uint8_t *out) {
+    const char table[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    size_t i = 0;
+    for (; i + 3 <= in_len; i += 3) {
+        uint32_t v = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+        *out++ = table[(v >> 18) & 0x3F];
+        *out++ = table[(v >> 12) & 0x3F];
+        *out++ = table[(v >> 6) & 0x3F];
+        *out++ = table[v & 0x3F];
+    }
+    if (in_len - i == 1) {
+        uint32_t v = in[i] << 16;
+        *out++ = table[(v >> 18) & 0x3F];
+        *out++ = table[(v >> 12) & 0x3F];
+    } else if (in_len - i == 2) {
+        uint32_t v = (in[i] << 16) | (in[i + 1] << 8);
+        *out++ = table[(v >> 18) & 0x3F];
+        *out++ = table[(v >> 12) & 0x3F];
+        *out++ = table[(v >> 6) & 0x3F];
+    }
+}
+
+// Only the "limited verification" of WebAuthn level 2 (section 5.8.1.2) is
+// done: clientDataJSON must start with the type and the challenge, and the
+// challenge must be the message. Origin and rpIdHash are not checked, there
+// is nothing on chain to check them against.
+static int webauthn_check_client_data(const uint8_t *client_data,
+                                      size_t client_data_len,
+                                      const uint8_t *msg) {
+    const char prefix[] = "{\"type\":\"webauthn.get\",\"challenge\":\"";
+    const size_t prefix_len = sizeof(prefix) - 1;
+    uint8_t challenge[WEBAUTHN_CHALLENGE_SIZE];
+
+    if (client_data_len < prefix_len + WEBAUTHN_CHALLENGE_SIZE + 1) {
+        return Secp256r1Err_WebAuthn;
+    }
+    if (memcmp(client_data, prefix, prefix_len) != 0) {
+        return Secp256r1Err_WebAuthn;
+    }
+    webauthn_base64url_encode(msg, BLAKE2B_BLOCK_SIZE, challenge);
+    if (memcmp(client_data + prefix_len, challenge, sizeof(challenge)) != 0) {
+        return Secp256r1Err_WebAuthn;
+    }
+    if (client_data[prefix_len + WEBAUTHN_CHALLENGE_SIZE] != '"') {
+        return Secp256r1Err_WebAuthn;
+    }
+    return 0;
+}
+
+// signature: pubkey(x | y) | r | s | authenticator data length(2, little
+// endian) | authenticator data | client data JSON length(2, little endian) |
+// client data JSON
+//
+// The authenticator signs authenticatorData | SHA256(clientDataJSON), and the
+// challenge in clientDataJSON is the message. DER signatures returned by
+// navigator.credentials.get() must be converted to r | s by the client.
+int validate_signature_webauthn(void *prefilled_data, const uint8_t *sig,
+                                size_t sig_len, const uint8_t *msg,
+                                size_t msg_len, uint8_t *output,
+                                size_t *output_len) {
+    int err = 0;
+
+    CHECK2(*output_len >= BLAKE160_SIZE, ERROR_INVALID_ARG);
+    CHECK2(msg_len == BLAKE2B_BLOCK_SIZE, ERROR_INVALID_ARG);
+    CHECK2(sig_len >= SECP256R1_DATA_SIZE + 2, ERROR_INVALID_ARG);
+
+    const uint8_t *p = sig + SECP256R1_DATA_SIZE;
+    const uint8_t *end = sig + sig_len;
+    size_t auth_data_len = p[0] | (p[1] << 8);
+    const uint8_t *auth_data = p + 2;
+    CHECK2(auth_data_len >= WEBAUTHN_AUTH_DATA_MIN_SIZE, ERROR_INVALID_ARG);
+    CHECK2((size_t)(end - auth_data) >= auth_data_len + 2, ERROR_INVALID_ARG);
+    p = auth_data + auth_data_len;
+    size_t client_data_len = p[0] | (p[1] << 8);
+    const uint8_t *client_data = p + 2;
+    CHECK2((size_t)(end - client_data) == client_data_len, ERROR_INVALID_ARG);
+
+    err = _check_pubkey_hash(prefilled_data, sig, SECP256R1_PUBKEY_SIZE, output,
+                             output_len);
+    CHECK(err);
+
+    CHECK2(auth_data[WEBAUTHN_FLAGS_INDEX] & WEBAUTHN_FLAG_USER_PRESENT,
+           Secp256r1Err_WebAuthn);
+    err = webauthn_check_client_data(client_data, client_data_len, msg);
+    CHECK(err);
+
+    uint8_t digest[SHA256_SIZE];
+    mbedtls_sha256_context sha256_ctx;
+    mbedtls_sha256_init(&sha256_ctx);
+    err = mbedtls_sha256_ret(client_data, client_data_len, digest, 0);
+    CHECK(err);
+    err = mbedtls_sha256_starts_ret(&sha256_ctx, 0);
+    CHECK(err);
+    err = mbedtls_sha256_update_ret(&sha256_ctx, auth_data, auth_data_len);
+    CHECK(err);
+    err = mbedtls_sha256_update_ret(&sha256_ctx, digest, sizeof(digest));
+    CHECK(err);
+    err = mbedtls_sha256_finish_ret(&sha256_ctx, digest);
+    CHECK(err);
+
+    err = _verify_secp256r1(sig, sig + SECP256R1_PUBKEY_SIZE, digest);
+    CHECK(err);
+exit:
+    return err;
+}
+
+#ifdef CKB_AUTH_BLS12381
+// Ciphersuite of the proof of possession scheme, minimal-pubkey-size variant
+// (pubkey in G1, signature in G2). Aggregating pubkeys of a committee is only
+// safe if every member has proven possession of its secret key, otherwise
+// one member can pick a rogue key that cancels the others out.
+static const char BLS12381_DST[] = "BLS_SIG_BLS12381G2_XMD:SHA-256_SSWU_RO_POP_";
+
+// signature: aggregated pubkey(48, compressed G1) | aggregated signature(96,
+// compressed G2)
+int validate_signature_bls12381(void *prefilled_data, const uint8_t *sig,
+                                size_t sig_len, const uint8_t *msg,
+                                size_t msg_len, uint8_t *output,
+                                size_t *output_len) {
+    int err = 0;
+
+    CHECK2(*output_len >= BLAKE160_SIZE, ERROR_INVALID_ARG);
+    CHECK2(sig_len == BLS12381_DATA_SIZE, ERROR_INVALID_ARG);
+    CHECK2(msg_len == BLAKE2B_BLOCK_SIZE, ERROR_INVALID_ARG);
+
+    err = _check_pubkey_hash(prefilled_data, sig, BLS12381_PUBKEY_SIZE, output,
+                             output_len);
+    CHECK(err);
+
+    blst_p1_affine pk;
+    blst_p2_affine agg_sig;
+    CHECK2(blst_p1_uncompress(&pk, sig) == BLST_SUCCESS, ERROR_BLS12381);
+    CHECK2(blst_p2_uncompress(&agg_sig, sig + BLS12381_PUBKEY_SIZE) ==
+               BLST_SUCCESS,
+           ERROR_BLS12381);
+    // Group membership of both points is checked here, and an infinity
+    // pubkey is rejected.
+    CHECK2(blst_core_verify_pk_in_g1(&pk, &agg_sig, true, msg, msg_len,
+                                     (const byte *)BLS12381_DST,
+                                     sizeof(BLS12381_DST) - 1, NULL,
+                                     0) == BLST_SUCCESS,
+           ERROR_BLS12381);
+exit:
+    return err;
+}
+#endif  // CKB_AUTH_BLS12381
+
+enum HashPreimageType {
+    HashPreimageBlake160 = 0,
+    HashPreimageSha256 = 1,     // first 20 bytes of sha256
+    HashPreimageHash160 = 2,    // ripemd160 of sha256, as bitcoin
+    HashPreimageRipemd160 = 3,
+};
+
+// signature: hash type(1) | preimage
+//
+// Only knowledge of the preimage is proven, the message is not signed. Once
+// the preimage is revealed in a transaction, anyone can reuse it.
+int validate_signature_hash_preimage(void *prefilled_data, const uint8_t *sig,
+                                     size_t sig_len, const uint8_t *msg,
+                                     size_t msg_len, uint8_t *output,
+                                     size_t *output_len) {
+    int err = 0;
+
+    CHECK2(*output_len >= BLAKE160_SIZE, ERROR_INVALID_ARG);
+    CHECK2(sig_len > 1, ERROR_INVALID_ARG);
+
+    const uint8_t *preimage = sig + 1;
+    size_t preimage_len = sig_len - 1;
+    uint8_t temp[BLAKE2B_BLOCK_SIZE] = {0};
+    switch (sig[0]) {
+        case HashPreimageBlake160: {
+            blake2b_state blake2b_ctx;
+            blake2b_init(&blake2b_ctx, BLAKE2B_BLOCK_SIZE);
+            blake2b_update(&blake2b_ctx, preimage, preimage_len);
+            blake2b_final(&blake2b_ctx, temp, BLAKE2B_BLOCK_SIZE);
+            break;
+        }
+        case HashPreimageSha256:
+            err = md_string(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                            preimage, preimage_len, temp);
+            CHECK(err);
+            break;
+        case HashPreimageHash160:
+            err = md_string(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                            preimage, preimage_len, temp);
+            CHECK(err);
+            err = md_string(mbedtls_md_info_from_type(MBEDTLS_MD_RIPEMD160),
+                            temp, SHA256_SIZE, temp);
+            CHECK(err);
+            break;
+        case HashPreimageRipemd160:
+            err = md_string(mbedtls_md_info_from_type(MBEDTLS_MD_RIPEMD160),
+                            preimage, preimage_len, temp);
+            CHECK(err);
+            break;
+        default:
+            CHECK2(false, ERROR_INVALID_ARG);
+    }
+
+    memcpy(output, temp, BLAKE160_SIZE);
+    *output_len = BLAKE160_SIZE;
+exit:
+    return err;
+}
 
 int convert_copy(const uint8_t *msg, size_t msg_len, uint8_t *new_msg,
                  size_t new_msg_len) {
@@ -607,6 +1121,13 @@ int convert_copy(const uint8_t *msg, size_t msg_len, uint8_t *new_msg,
     return 0;
 }
 
+int convert_sha256_message(const uint8_t *msg, size_t msg_len,
+                           uint8_t *new_msg, size_t new_msg_len) {
+    if (msg_len != new_msg_len || msg_len != BLAKE2B_BLOCK_SIZE)
+        return ERROR_INVALID_ARG;
+    return mbedtls_sha256_ret(msg, msg_len, new_msg, 0);
+}
+
 int convert_eth_message(const uint8_t *msg, size_t msg_len, uint8_t *new_msg,
                         size_t new_msg_len) {
     if (msg_len != new_msg_len || msg_len != BLAKE2B_BLOCK_SIZE)
@@ -781,8 +1302,10 @@ static int verify(uint8_t *pubkey_hash, const uint8_t *sig, uint32_t sig_len,
 
     uint8_t output_pubkey_hash[BLAKE160_SIZE];
     size_t output_len = BLAKE160_SIZE;
-    err = func(NULL, sig, sig_len, new_msg, sizeof(new_msg), output_pubkey_hash,
-               &output_len);
+    // The expected hash is handed to validators that can check it before
+    // verifying the signature.
+    err = func(pubkey_hash, sig, sig_len, new_msg, sizeof(new_msg),
+               output_pubkey_hash, &output_len);
     CHECK(err);
 
     int same = memcmp(pubkey_hash, output_pubkey_hash, BLAKE160_SIZE);
@@ -839,7 +1362,14 @@ int verify_multisig(const uint8_t *lock_bytes, size_t lock_bytes_len,
     // Based on the number of public keys and thresholds, we can calculate
     // the required length of the lock field.
     size_t multisig_script_len = FLAGS_SIZE + BLAKE160_SIZE * pubkeys_cnt;
-    size_t signatures_len = SIGNATURE_SIZE * threshold;
+    // Signatures are either all 65 bytes or all EIP-2098 compact ones, which
+    // saves threshold bytes in the witness.
+    size_t signature_size = SIGNATURE_SIZE;
+    if (lock_bytes_len ==
+        multisig_script_len + SECP256K1_COMPACT_SIGNATURE_SIZE * threshold) {
+        signature_size = SECP256K1_COMPACT_SIGNATURE_SIZE;
+    }
+    size_t signatures_len = signature_size * threshold;
     size_t required_lock_len = multisig_script_len + signatures_len;
     if (lock_bytes_len != required_lock_len) {
         return ERROR_WITNESS_SIZE;
@@ -870,31 +1400,38 @@ int verify_multisig(const uint8_t *lock_bytes, size_t lock_bytes_len,
     // contract, you don't have to wait for the foundation to ship a new
     // cryptographic algorithm. You can just build and ship your own.
     secp256k1_context context;
-    uint8_t secp_data[CKB_SECP256K1_DATA_SIZE];
-    ret = ckb_secp256k1_custom_verify_only_initialize(&context, secp_data);
+    uint8_t secp_data[SECP256K1_DATA_BUFFER_SIZE];
+    secp256k1_context *ctx = NULL;
+    ret = _secp256k1_context(&context, secp_data, &ctx);
     if (ret != 0) return ret;
 
     // We will perform *threshold* number of signature verifications here.
     for (size_t i = 0; i < threshold; i++) {
         // Load signature
         secp256k1_ecdsa_recoverable_signature signature;
-        size_t signature_offset = multisig_script_len + i * SIGNATURE_SIZE;
+        size_t signature_offset = multisig_script_len + i * signature_size;
+        const uint8_t *signature_bytes = &lock_bytes[signature_offset];
+        uint8_t expanded[SIGNATURE_SIZE];
+        if (signature_size == SECP256K1_COMPACT_SIGNATURE_SIZE) {
+            _expand_compact_signature(signature_bytes, expanded);
+            signature_bytes = expanded;
+        }
         if (secp256k1_ecdsa_recoverable_signature_parse_compact(
-                &context, &signature, &lock_bytes[signature_offset],
-                lock_bytes[signature_offset + RECID_INDEX]) == 0) {
+                ctx, &signature, signature_bytes,
+                signature_bytes[RECID_INDEX]) == 0) {
             return ERROR_SECP_PARSE_SIGNATURE;
         }
 
         // verify signature and Recover pubkey
         secp256k1_pubkey pubkey;
-        if (secp256k1_ecdsa_recover(&context, &pubkey, &signature, message) !=
+        if (secp256k1_ecdsa_recover(ctx, &pubkey, &signature, message) !=
             1) {
             return ERROR_SECP_RECOVER_PUBKEY;
         }
 
         // Calculate the blake160 hash of the derived public key
         size_t pubkey_size = PUBKEY_SIZE;
-        if (secp256k1_ec_pubkey_serialize(&context, temp, &pubkey_size, &pubkey,
+        if (secp256k1_ec_pubkey_serialize(ctx, temp, &pubkey_size, &pubkey,
                                           SECP256K1_EC_COMPRESSED) != 1) {
             return ERROR_SECP_SERIALIZE_PUBKEY;
         }
@@ -943,6 +1480,151 @@ int verify_multisig(const uint8_t *lock_bytes, size_t lock_bytes_len,
     return 0;
 }
 
+__attribute__((visibility("default"))) int ckb_auth_validate(
+    uint8_t auth_algorithm_id, const uint8_t *signature,
+    uint32_t signature_size, const uint8_t *message, uint32_t message_size,
+    uint8_t *pubkey_hash, uint32_t pubkey_hash_size);
+
+static bool _is_secp256k1_algorithm(uint8_t auth_algorithm_id) {
+    switch (auth_algorithm_id) {
+        case AuthAlgorithmIdCkb:
+        case AuthAlgorithmIdEthereum:
+        case AuthAlgorithmIdEos:
+        case AuthAlgorithmIdTron:
+        case AuthAlgorithmIdBitcoin:
+        case AuthAlgorithmIdDogecoin:
+        case AuthAlgorithmIdCkbMultisig:
+        case AuthAlgorithmIdSchnorr:
+        case AuthAlgorithmIdLitecoin:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Composite auth: m of n entries, each one with its own algorithm.
+//
+// pubkey hash: blake160 of the policy,
+//   threshold(1) | n(1) | n * (algorithm id(1) | pubkey hash(20))
+// signature: policy | signatures, each of them being
+//   index of the policy entry(1) | length(2, little endian) | signature
+//
+// Signatures are listed in strictly increasing index order, so one entry
+// can't be counted twice. There are exactly threshold of them, trailing bytes
+// are rejected so that the witness can't be padded. All entries are verified
+// in this process, the secp256k1 based ones sharing one context.
+int verify_composite(const uint8_t *sig, size_t sig_len, const uint8_t *msg,
+                     size_t msg_len, uint8_t *pubkey_hash) {
+    int err = 0;
+
+    CHECK2(sig_len >= COMPOSITE_HEADER_SIZE, ERROR_INVALID_ARG);
+    uint8_t threshold = sig[0];
+    uint8_t count = sig[1];
+    CHECK2(threshold > 0 && threshold <= count, ERROR_INVALID_ARG);
+    size_t policy_len = COMPOSITE_HEADER_SIZE + (size_t)count * CKB_AUTH_LEN;
+    CHECK2(sig_len >= policy_len, ERROR_INVALID_ARG);
+
+    uint8_t policy_hash[BLAKE160_SIZE];
+    size_t policy_hash_len = BLAKE160_SIZE;
+    err = _check_pubkey_hash(pubkey_hash, sig, policy_len, policy_hash,
+                             &policy_hash_len);
+    CHECK(err);
+
+    secp256k1_context context;
+    uint8_t secp_data[CKB_SECP256K1_DATA_SIZE];
+
+    const uint8_t *p = sig + policy_len;
+    const uint8_t *end = sig + sig_len;
+    int last_index = -1;
+    uint8_t verified = 0;
+    while (verified < threshold) {
+        CHECK2(end - p >= COMPOSITE_SIGNATURE_HEADER_SIZE, ERROR_MISMATCHED);
+        uint8_t index = p[0];
+        size_t len = p[1] | (p[2] << 8);
+        p += COMPOSITE_SIGNATURE_HEADER_SIZE;
+        CHECK2(index < count && (int)index > last_index, ERROR_INVALID_ARG);
+        CHECK2((size_t)(end - p) >= len, ERROR_INVALID_ARG);
+
+        const uint8_t *entry =
+            sig + COMPOSITE_HEADER_SIZE + (size_t)index * CKB_AUTH_LEN;
+        uint8_t algorithm_id = entry[0];
+        // No nesting, it bounds both the recursion and the stack.
+        CHECK2(algorithm_id != AuthAlgorithmIdComposite, ERROR_INVALID_ARG);
+        if (_is_secp256k1_algorithm(algorithm_id) &&
+            g_shared_secp256k1_context == NULL) {
+            err = ckb_secp256k1_custom_verify_only_initialize(&context,
+                                                              secp_data);
+            CHECK(err);
+            g_shared_secp256k1_context = &context;
+        }
+        uint8_t entry_pubkey_hash[BLAKE160_SIZE];
+        memcpy(entry_pubkey_hash, entry + 1, BLAKE160_SIZE);
+        err = ckb_auth_validate(algorithm_id, p, len, msg, msg_len,
+                                entry_pubkey_hash, BLAKE160_SIZE);
+        CHECK(err);
+
+        last_index = index;
+        p += len;
+        verified++;
+    }
+    CHECK2(p == end, ERROR_INVALID_ARG);
+
+exit:
+    g_shared_secp256k1_context = NULL;
+    return err;
+}
+
+// In-run cache of successful verifications. A lock may validate the same
+// (algorithm id, signature, message, pubkey hash) several times in one run,
+// e.g. once per output rule; repeated ones only cost one blake2b of the
+// inputs. Only the hash of successful inputs is kept, in a small ring, so it
+// stays well within the dynamic linking memory budget.
+#define AUTH_RESULT_CACHE_SIZE 8
+
+static uint8_t g_auth_result_cache[AUTH_RESULT_CACHE_SIZE][BLAKE2B_BLOCK_SIZE];
+static size_t g_auth_result_cache_count = 0;
+
+static void _auth_result_cache_key(uint8_t auth_algorithm_id,
+                                   const uint8_t *signature,
+                                   uint32_t signature_size,
+                                   const uint8_t *message,
+                                   uint32_t message_size,
+                                   const uint8_t *pubkey_hash, uint8_t *key) {
+    blake2b_state ctx;
+    blake2b_init(&ctx, BLAKE2B_BLOCK_SIZE);
+    blake2b_update(&ctx, &auth_algorithm_id, 1);
+    blake2b_update(&ctx, &signature_size, sizeof(signature_size));
+    blake2b_update(&ctx, signature, signature_size);
+    blake2b_update(&ctx, &message_size, sizeof(message_size));
+    blake2b_update(&ctx, message, message_size);
+    blake2b_update(&ctx, pubkey_hash, BLAKE160_SIZE);
+    blake2b_final(&ctx, key, BLAKE2B_BLOCK_SIZE);
+}
+
+static bool _auth_result_cache_hit(const uint8_t *key) {
+    size_t count = g_auth_result_cache_count < AUTH_RESULT_CACHE_SIZE
+                       ? g_auth_result_cache_count
+                       : AUTH_RESULT_CACHE_SIZE;
+    for (size_t i = 0; i < count; i++) {
+        if (memcmp(g_auth_result_cache[i], key, BLAKE2B_BLOCK_SIZE) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void _auth_result_cache_insert(const uint8_t *key) {
+    memcpy(g_auth_result_cache[g_auth_result_cache_count %
+                               AUTH_RESULT_CACHE_SIZE],
+           key, BLAKE2B_BLOCK_SIZE);
+    g_auth_result_cache_count++;
+}
+
+static int _ckb_auth_validate(uint8_t auth_algorithm_id,
+                              const uint8_t *signature,
+                              uint32_t signature_size, const uint8_t *message,
+                              uint32_t message_size, uint8_t *pubkey_hash);
+
 // dynamic linking entry
 __attribute__((visibility("default"))) int ckb_auth_validate(
     uint8_t auth_algorithm_id, const uint8_t *signature,
@@ -954,23 +1636,54 @@ __attribute__((visibility("default"))) int ckb_auth_validate(
     CHECK2(message_size > 0, ERROR_INVALID_ARG);
     CHECK2(pubkey_hash_size == BLAKE160_SIZE, ERROR_INVALID_ARG);
 
+    // Not worth a blake2b: these are as cheap as computing the key.
+    if (auth_algorithm_id == AuthAlgorithmIdHashPreimage ||
+        auth_algorithm_id == AuthAlgorithmIdOwnerLock) {
+        return _ckb_auth_validate(auth_algorithm_id, signature, signature_size,
+                                  message, message_size, pubkey_hash);
+    }
+
+    uint8_t key[BLAKE2B_BLOCK_SIZE];
+    _auth_result_cache_key(auth_algorithm_id, signature, signature_size,
+                           message, message_size, pubkey_hash, key);
+    if (_auth_result_cache_hit(key)) {
+        return 0;
+    }
+    err = _ckb_auth_validate(auth_algorithm_id, signature, signature_size,
+                             message, message_size, pubkey_hash);
+    CHECK(err);
+    _auth_result_cache_insert(key);
+
+exit:
+    return err;
+}
+
+static int _ckb_auth_validate(uint8_t auth_algorithm_id,
+                              const uint8_t *signature,
+                              uint32_t signature_size, const uint8_t *message,
+                              uint32_t message_size, uint8_t *pubkey_hash) {
+    int err = 0;
     if (auth_algorithm_id == AuthAlgorithmIdCkb) {
-        CHECK2(signature_size == SECP256K1_SIGNATURE_SIZE, ERROR_INVALID_ARG);
+        CHECK2(_is_secp256k1_signature_size(signature_size),
+               ERROR_INVALID_ARG);
         err = verify(pubkey_hash, signature, signature_size, message,
                      message_size, validate_signature_ckb, convert_copy);
         CHECK(err);
     } else if (auth_algorithm_id == AuthAlgorithmIdEthereum) {
-        CHECK2(signature_size == SECP256K1_SIGNATURE_SIZE, ERROR_INVALID_ARG);
+        CHECK2(_is_secp256k1_signature_size(signature_size),
+               ERROR_INVALID_ARG);
         err = verify(pubkey_hash, signature, signature_size, message,
                      message_size, validate_signature_eth, convert_eth_message);
         CHECK(err);
     } else if (auth_algorithm_id == AuthAlgorithmIdEos) {
-        CHECK2(signature_size == SECP256K1_SIGNATURE_SIZE, ERROR_INVALID_ARG);
+        CHECK2(_is_secp256k1_signature_size(signature_size),
+               ERROR_INVALID_ARG);
         err = verify(pubkey_hash, signature, signature_size, message,
                      message_size, validate_signature_eth, convert_eos_message);
         CHECK(err);
     } else if (auth_algorithm_id == AuthAlgorithmIdTron) {
-        CHECK2(signature_size == SECP256K1_SIGNATURE_SIZE, ERROR_INVALID_ARG);
+        CHECK2(_is_secp256k1_signature_size(signature_size),
+               ERROR_INVALID_ARG);
         err =
             verify(pubkey_hash, signature, signature_size, message,
                    message_size, validate_signature_eth, convert_tron_message);
@@ -996,6 +1709,14 @@ __attribute__((visibility("default"))) int ckb_auth_validate(
         err = verify(pubkey_hash, signature, signature_size, message,
                      message_size, validate_signature_schnorr, convert_copy);
         CHECK(err);
+    } else if (auth_algorithm_id == AuthAlgorithmIdRsa) {
+        err = verify(pubkey_hash, signature, signature_size, message,
+                     message_size, validate_signature_rsa, convert_copy);
+        CHECK(err);
+    } else if (auth_algorithm_id == AuthAlgorithmIdIso97962) {
+        err = verify(pubkey_hash, signature, signature_size, message,
+                     message_size, validate_signature_iso97962, convert_copy);
+        CHECK(err);
     } else if (auth_algorithm_id == AuthAlgorithmIdCardano) {
         err = verify(pubkey_hash, signature, signature_size, message,
                      message_size, validate_signature_cardano, convert_copy);
@@ -1008,6 +1729,30 @@ __attribute__((visibility("default"))) int ckb_auth_validate(
         err = verify(pubkey_hash, signature, signature_size, message,
                      message_size, validate_signature_solana, convert_copy);
         CHECK(err);
+    } else if (auth_algorithm_id == AuthAlgorithmIdSecp256r1) {
+        err = verify(pubkey_hash, signature, signature_size, message,
+                     message_size, validate_signature_secp256r1,
+                     convert_sha256_message);
+        CHECK(err);
+    } else if (auth_algorithm_id == AuthAlgorithmIdWebAuthn) {
+        err = verify(pubkey_hash, signature, signature_size, message,
+                     message_size, validate_signature_webauthn, convert_copy);
+        CHECK(err);
+#ifdef CKB_AUTH_BLS12381
+    } else if (auth_algorithm_id == AuthAlgorithmIdBls12381) {
+        err = verify(pubkey_hash, signature, signature_size, message,
+                     message_size, validate_signature_bls12381, convert_copy);
+        CHECK(err);
+#endif
+    } else if (auth_algorithm_id == AuthAlgorithmIdHashPreimage) {
+        err = verify(pubkey_hash, signature, signature_size, message,
+                     message_size, validate_signature_hash_preimage,
+                     convert_copy);
+        CHECK(err);
+    } else if (auth_algorithm_id == AuthAlgorithmIdComposite) {
+        err = verify_composite(signature, signature_size, message,
+                               message_size, pubkey_hash);
+        CHECK(err);
     } else if (auth_algorithm_id == AuthAlgorithmIdOwnerLock) {
         CHECK2(is_lock_script_hash_present(pubkey_hash), ERROR_MISMATCHED);
         err = 0;
@@ -1031,6 +1776,10 @@ int simulator_main(int argc, char *argv[]) {
 #else
 // spawn entry
 int main(int argc, char *argv[]) {
+#ifndef CKB_AUTH_NO_RELOCATION
+// build/auth is a PIE so it can also be loaded by dynamic linking, apply the
+// R_RISCV_RELATIVE relocations ourselves. build/auth-spawn is linked at a
+// fixed address and skips this.
 // fix error:
 // c/auth.c:810:50: error: array subscript 0 is outside array bounds of
 // 'uint64_t[0]' {aka 'long unsigned int[]'} [-Werror=array-bounds]
@@ -1074,11 +1823,27 @@ int main(int argc, char *argv[]) {
 #if defined(__GNUC__) && (__GNUC__ >= 12)
 #pragma GCC diagnostic pop
 #endif
+#endif  // CKB_AUTH_NO_RELOCATION
 
 #endif
 
     int err = 0;
 
+    if (argc == 1) {
+        // exec entry, see ckb_auth_exec_encode
+        size_t len = 0;
+        uint8_t *arg = (uint8_t *)argv[0];
+        CHECK2(!ckb_auth_exec_decode(arg, &len), ERROR_SPAWN_INVALID_SIG);
+        CHECK2(len >= CKB_AUTH_EXEC_HEADER_SIZE, ERROR_SPAWN_INVALID_LENGTH);
+        uint8_t pubkey_hash[BLAKE160_SIZE];
+        memcpy(pubkey_hash, arg + 1, BLAKE160_SIZE);
+        err = ckb_auth_validate(arg[0], arg + CKB_AUTH_EXEC_HEADER_SIZE,
+                                len - CKB_AUTH_EXEC_HEADER_SIZE,
+                                arg + 1 + BLAKE160_SIZE, BLAKE2B_BLOCK_SIZE,
+                                pubkey_hash, BLAKE160_SIZE);
+        goto exit;
+    }
+
     if (argc != 4) {
         return -1;
     }
@@ -1105,7 +1870,9 @@ int main(int argc, char *argv[]) {
     }
 
     uint8_t algorithm_id = 0;
-    uint8_t signature[signature_len / 2];
+    // Decoded in place: argv already lives on our stack, a second copy of a
+    // large signature would only grow the memory we need.
+    uint8_t *signature = (uint8_t *)ARGV_SIGNATURE;
     uint8_t message[BLAKE2B_BLOCK_SIZE];
     uint8_t pubkey_hash[BLAKE160_SIZE];
 
@@ -1117,7 +1884,8 @@ int main(int argc, char *argv[]) {
 
     // signature
     CHECK2(
-        !ckb_hex2bin(ARGV_SIGNATURE, signature, signature_len, &signature_len),
+        !ckb_hex2bin(ARGV_SIGNATURE, signature, signature_len / 2,
+                     &signature_len),
         ERROR_SPAWN_INVALID_SIG);
 
     // message
@@ -0,0 +1,18 @@
+#ifndef CKB_BENCH_MBEDTLS_CONFIG_H_
+#define CKB_BENCH_MBEDTLS_CONFIG_H_
+
+/*
+ * mbedtls configuration of build/bench_native: the message digests enabled
+ * by deps/mbedtls-config-template.h, with the platform layer of the host
+ * instead of the CKB-VM replacements.
+ */
+#define MBEDTLS_MD_C
+#define MBEDTLS_MD5_C
+#define MBEDTLS_RIPEMD160_C
+#define MBEDTLS_SHA1_C
+#define MBEDTLS_SHA256_C
+#define MBEDTLS_SHA512_C
+
+#include "mbedtls/check_config.h"
+
+#endif
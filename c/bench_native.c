@@ -0,0 +1,288 @@
+/*
+ * Host native micro-benchmarks of the primitives build/auth spends its cycles
+ * in, compiled from the same sources (see `make bench-native`). Meant to
+ * screen changes to a kernel before measuring cycles in CKB-VM: the numbers
+ * here are only comparable with each other, on the same machine.
+ *
+ * usage: build/bench_native [-t milliseconds per benchmark] [name filter]
+ */
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "blake2b.h"
+#include "ckb_keccak256.h"
+#include "ed25519.h"
+#include "mbedtls/md.h"
+
+#define HAVE_CONFIG_H 1
+#ifdef CKB_SECP256K1_FIELD_CKBVM
+#include "secp256k1_ckbvm/field_5x52_ckbvm_impl.h"
+#endif
+#include <secp256k1.c>
+
+#include "ed25519_key_cache.h"
+
+#define LARGE_INPUT_SIZE 1024
+
+static uint8_t g_input[LARGE_INPUT_SIZE];
+static uint8_t g_message[32];
+static volatile uint8_t g_sink;
+
+// secp256k1, set up as secp256k1_helper_20210801.h does in CKB-VM, with the
+// precomputed tables linked in instead of loaded from a cell dep.
+static secp256k1_context g_secp256k1_ctx;
+static secp256k1_ecdsa_recoverable_signature g_recoverable_signature;
+static secp256k1_ecdsa_signature g_signature;
+static secp256k1_pubkey g_secp256k1_pubkey;
+
+static uint8_t g_ed25519_pubkey[32];
+static uint8_t g_ed25519_signature[64];
+
+static void bench_keccak256_32(void) {
+    uint8_t hash[32];
+    keccak256(g_input, 32, hash);
+    g_sink ^= hash[0];
+}
+
+static void bench_keccak256_1k(void) {
+    uint8_t hash[32];
+    keccak256(g_input, LARGE_INPUT_SIZE, hash);
+    g_sink ^= hash[0];
+}
+
+static void blake2b_256(const uint8_t *input, size_t len) {
+    uint8_t hash[32];
+    blake2b_state ctx;
+    blake2b_init(&ctx, 32);
+    blake2b_update(&ctx, input, len);
+    blake2b_final(&ctx, hash, 32);
+    g_sink ^= hash[0];
+}
+
+static void bench_blake2b_32(void) { blake2b_256(g_input, 32); }
+
+static void bench_blake2b_1k(void) { blake2b_256(g_input, LARGE_INPUT_SIZE); }
+
+static void md(mbedtls_md_type_t type, const uint8_t *input, size_t len) {
+    uint8_t hash[MBEDTLS_MD_MAX_SIZE];
+    mbedtls_md(mbedtls_md_info_from_type(type), input, len, hash);
+    g_sink ^= hash[0];
+}
+
+static void bench_sha256_32(void) { md(MBEDTLS_MD_SHA256, g_input, 32); }
+
+static void bench_sha256_1k(void) {
+    md(MBEDTLS_MD_SHA256, g_input, LARGE_INPUT_SIZE);
+}
+
+static void bench_ripemd160_32(void) { md(MBEDTLS_MD_RIPEMD160, g_input, 32); }
+
+// bitcoin style pubkey hash, as validate_signature_btc computes it
+static void bench_hash160(void) {
+    uint8_t sha256[32];
+    uint8_t hash[20];
+    mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), g_input, 33,
+               sha256);
+    mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_RIPEMD160), sha256, 32,
+               hash);
+    g_sink ^= hash[0];
+}
+
+static void bench_secp256k1_recover(void) {
+    secp256k1_pubkey pubkey;
+    int ret = secp256k1_ecdsa_recover(&g_secp256k1_ctx, &pubkey,
+                                      &g_recoverable_signature, g_message);
+    g_sink ^= (uint8_t)ret;
+}
+
+static void bench_secp256k1_verify(void) {
+    int ret = secp256k1_ecdsa_verify(&g_secp256k1_ctx, &g_signature, g_message,
+                                     &g_secp256k1_pubkey);
+    g_sink ^= (uint8_t)ret;
+}
+
+static void bench_ed25519_verify(void) {
+    int ret = ed25519_verify(g_ed25519_signature, g_message, sizeof(g_message),
+                             g_ed25519_pubkey);
+    g_sink ^= (uint8_t)ret;
+}
+
+// with the odd multiples of the key cached, as for a key signing twice
+static void bench_ed25519_verify_cached(void) {
+    int ret = ed25519_verify_cached(g_ed25519_signature, g_message,
+                                    sizeof(g_message), g_ed25519_pubkey);
+    g_sink ^= (uint8_t)ret;
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} Bench;
+
+static const Bench g_benches[] = {
+    {"keccak256/32", bench_keccak256_32},
+    {"keccak256/1024", bench_keccak256_1k},
+    {"blake2b-256/32", bench_blake2b_32},
+    {"blake2b-256/1024", bench_blake2b_1k},
+    {"sha256/32", bench_sha256_32},
+    {"sha256/1024", bench_sha256_1k},
+    {"ripemd160/32", bench_ripemd160_32},
+    {"hash160/33", bench_hash160},
+    {"secp256k1-recover", bench_secp256k1_recover},
+    {"secp256k1-verify", bench_secp256k1_verify},
+    {"ed25519-verify", bench_ed25519_verify},
+    {"ed25519-verify-cached", bench_ed25519_verify_cached},
+};
+
+static int setup(void) {
+    for (size_t i = 0; i < sizeof(g_input); i++) {
+        g_input[i] = (uint8_t)(i * 7 + 1);
+    }
+    memcpy(g_message, g_input, sizeof(g_message));
+
+    // Signing isn't measured, the library's own context does it.
+    secp256k1_context *sign_ctx =
+        secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+    uint8_t seckey[32];
+    memset(seckey, 0x11, sizeof(seckey));
+    if (!secp256k1_ecdsa_sign_recoverable(sign_ctx, &g_recoverable_signature,
+                                          g_message, seckey, NULL, NULL) ||
+        !secp256k1_ecdsa_sign(sign_ctx, &g_signature, g_message, seckey, NULL,
+                              NULL) ||
+        !secp256k1_ec_pubkey_create(sign_ctx, &g_secp256k1_pubkey, seckey)) {
+        return -1;
+    }
+    secp256k1_context_destroy(sign_ctx);
+
+    g_secp256k1_ctx.illegal_callback = default_illegal_callback;
+    g_secp256k1_ctx.error_callback = default_error_callback;
+    secp256k1_ecmult_context_init(&g_secp256k1_ctx.ecmult_ctx);
+    secp256k1_ecmult_gen_context_init(&g_secp256k1_ctx.ecmult_gen_ctx);
+    g_secp256k1_ctx.ecmult_ctx.pre_g =
+        (secp256k1_ge_storage(*)[])secp256k1_ecmult_static_pre_context;
+    g_secp256k1_ctx.ecmult_ctx.pre_g_128 =
+        (secp256k1_ge_storage(*)[])secp256k1_ecmult_static_pre128_context;
+
+    uint8_t seed[32];
+    uint8_t private_key[64];
+    memset(seed, 0x22, sizeof(seed));
+    ed25519_create_keypair(g_ed25519_pubkey, private_key, seed);
+    ed25519_sign(g_ed25519_signature, g_message, sizeof(g_message),
+                 g_ed25519_pubkey, private_key);
+
+    // the benchmarks must measure the success path
+    secp256k1_pubkey recovered;
+    if (!secp256k1_ecdsa_recover(&g_secp256k1_ctx, &recovered,
+                                 &g_recoverable_signature, g_message) ||
+        memcmp(&recovered, &g_secp256k1_pubkey, sizeof(recovered)) != 0 ||
+        !secp256k1_ecdsa_verify(&g_secp256k1_ctx, &g_signature, g_message,
+                                &g_secp256k1_pubkey) ||
+        !ed25519_verify(g_ed25519_signature, g_message, sizeof(g_message),
+                        g_ed25519_pubkey) ||
+        !ed25519_verify_cached(g_ed25519_signature, g_message,
+                               sizeof(g_message), g_ed25519_pubkey)) {
+        return -1;
+    }
+    return 0;
+}
+
+// Retired user space instructions, -1 when the kernel doesn't expose the
+// counter (e.g. in containers, or with perf_event_paranoid > 2).
+static int open_instruction_counter(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void run_bench(const Bench *bench, uint64_t min_ns, int counter) {
+    // warm up, and find how many iterations fill min_ns
+    uint64_t iterations = 1;
+    uint64_t elapsed = 0;
+    while (1) {
+        uint64_t begin = now_ns();
+        for (uint64_t i = 0; i < iterations; i++) {
+            bench->run();
+        }
+        elapsed = now_ns() - begin;
+        if (elapsed >= min_ns / 10 || iterations >= (1ull << 40)) {
+            break;
+        }
+        iterations *= 2;
+    }
+    iterations = iterations * min_ns / (elapsed ? elapsed : 1) + 1;
+
+    uint64_t instructions = 0;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    uint64_t begin = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        bench->run();
+    }
+    elapsed = now_ns() - begin;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &instructions, sizeof(instructions)) !=
+            sizeof(instructions)) {
+            instructions = 0;
+        }
+    }
+
+    printf("%-24s %12lu %14.1f", bench->name, (unsigned long)iterations,
+           (double)elapsed / (double)iterations);
+    if (counter >= 0) {
+        printf(" %16.1f\n", (double)instructions / (double)iterations);
+    } else {
+        printf(" %16s\n", "-");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t min_ns = 500 * 1000000ull;
+    const char *filter = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            min_ns = strtoull(argv[++i], NULL, 10) * 1000000ull;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    if (setup() != 0) {
+        fprintf(stderr, "failed to set up the benchmark inputs\n");
+        return 1;
+    }
+    int counter = open_instruction_counter();
+    printf("%-24s %12s %14s %16s\n", "benchmark", "iterations", "ns/op",
+           "instructions/op");
+    for (size_t i = 0; i < sizeof(g_benches) / sizeof(g_benches[0]); i++) {
+        if (filter != NULL && strstr(g_benches[i].name, filter) == NULL) {
+            continue;
+        }
+        run_bench(&g_benches[i], min_ns, counter);
+    }
+    if (counter >= 0) {
+        close(counter);
+    }
+    return 0;
+}
@@ -12,7 +12,7 @@ typedef struct CkbAuthType {
 } CkbAuthType;
 
 enum EntryCategoryType {
-    // EntryCategoryExec = 0,
+    EntryCategoryExec = 0,
     EntryCategoryDynamicLinking = 1,
     EntryCategorySpawn = 2,
 };
@@ -38,9 +38,65 @@ enum AuthAlgorithmIdType {
     AuthAlgorithmIdCardano = 11,
     AuthAlgorithmIdMonero = 12,
     AuthAlgorithmIdSolana = 13,
+    AuthAlgorithmIdSecp256r1 = 14,
+    AuthAlgorithmIdWebAuthn = 15,
+    AuthAlgorithmIdBls12381 = 16,
+    AuthAlgorithmIdHashPreimage = 17,
+    AuthAlgorithmIdComposite = 18,
     AuthAlgorithmIdOwnerLock = 0xFC,
 };
 
+// Exec entry: the auth binary replaces the calling script through ckb_exec,
+// so there is neither a code buffer to reserve nor a child process to
+// create, but ckb_auth only returns on failure to exec. Its exit code is the
+// one of the script, so it must be the last thing a lock checks.
+//
+// argv is a single string:
+//   algorithm id(1) | pubkey hash(20) | message(32) | signature
+// with 0x00 escaped as 0xFE 0x01 and 0xFE as 0xFE 0x02, which is about 1%
+// bigger for random data, instead of the 2x of hex.
+#define CKB_AUTH_EXEC_ESCAPE 0xFE
+#define CKB_AUTH_EXEC_HEADER_SIZE (1 + 20 + 32)
+#define CKB_AUTH_EXEC_MAX_SIGNATURE_SIZE (1024 * 8)
+
+// Escapes in_len bytes into out, which must hold 2 * in_len bytes. Returns
+// the number of bytes written.
+static inline size_t ckb_auth_exec_encode(const uint8_t *in, size_t in_len,
+                                          uint8_t *out) {
+    size_t len = 0;
+    for (size_t i = 0; i < in_len; i++) {
+        if (in[i] == 0 || in[i] == CKB_AUTH_EXEC_ESCAPE) {
+            out[len++] = CKB_AUTH_EXEC_ESCAPE;
+            out[len++] = in[i] == 0 ? 1 : 2;
+        } else {
+            out[len++] = in[i];
+        }
+    }
+    return len;
+}
+
+// Unescapes a NUL terminated argv string in place, storing the decoded
+// length in len. Returns non zero on a malformed escape.
+static inline int ckb_auth_exec_decode(uint8_t *buf, size_t *len) {
+    uint8_t *out = buf;
+    for (const uint8_t *p = buf; *p != 0; p++) {
+        if (*p != CKB_AUTH_EXEC_ESCAPE) {
+            *out++ = *p;
+            continue;
+        }
+        p++;
+        if (*p == 1) {
+            *out++ = 0;
+        } else if (*p == 2) {
+            *out++ = CKB_AUTH_EXEC_ESCAPE;
+        } else {
+            return CKB_INVALID_DATA;
+        }
+    }
+    *len = out - buf;
+    return 0;
+}
+
 typedef int (*ckb_auth_validate_t)(uint8_t auth_algorithm_id,
                                    const uint8_t *signature,
                                    uint32_t signature_size,
@@ -48,7 +104,15 @@ typedef int (*ckb_auth_validate_t)(uint8_t auth_algorithm_id,
                                    uint32_t message_size, uint8_t *pubkey_hash,
                                    uint32_t pubkey_hash_size);
 
-static uint8_t g_code_buff[300 * 1024] __attribute__((aligned(RISCV_PGSIZE)));
+// Code buffer for the dynamically linked auth binary. Callers linking a
+// larger build/auth (e.g. built with `make BLS=1`, which adds blst) define
+// CKB_AUTH_DL_BUFF_SIZE before including this header, up to the 512 KB
+// DLContext of ckb-auth-rs.
+#ifndef CKB_AUTH_DL_BUFF_SIZE
+#define CKB_AUTH_DL_BUFF_SIZE (300 * 1024)
+#endif
+static uint8_t g_code_buff[CKB_AUTH_DL_BUFF_SIZE]
+    __attribute__((aligned(RISCV_PGSIZE)));
 
 int ckb_auth(CkbEntryType *entry, CkbAuthType *id, const uint8_t *signature,
              uint32_t signature_size, const uint8_t *message32) {
@@ -109,6 +173,22 @@ int ckb_auth(CkbEntryType *entry, CkbAuthType *id, const uint8_t *signature,
                              &spawn_args);
         if (err != 0) return err;
         return exit_code;
+    } else if (entry->entry_category == EntryCategoryExec) {
+        if (signature_size > CKB_AUTH_EXEC_MAX_SIGNATURE_SIZE) {
+            return CKB_INVALID_DATA;
+        }
+        uint8_t arg[(CKB_AUTH_EXEC_HEADER_SIZE + signature_size) * 2 + 1];
+        size_t len = 0;
+        len += ckb_auth_exec_encode(&id->algorithm_id, 1, arg + len);
+        len += ckb_auth_exec_encode(id->content, 20, arg + len);
+        len += ckb_auth_exec_encode(message32, 32, arg + len);
+        len += ckb_auth_exec_encode(signature, signature_size, arg + len);
+        arg[len] = 0;
+
+        const char *argv[1] = {(const char *)arg};
+        // only returns when exec fails
+        return ckb_exec_cell(entry->code_hash, entry->hash_type, 0, 0, 1,
+                             argv);
     } else {
         return CKB_INVALID_DATA;
     }
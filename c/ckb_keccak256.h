@@ -20,6 +20,7 @@
 #ifndef __KECCAK256_H_
 #define __KECCAK256_H_
 
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -33,8 +34,6 @@ typedef struct SHA3_CTX {
     uint64_t message[sha3_max_rate_in_qwords];
     /* count of bytes in the message[] buffer */
     uint16_t rest;
-    /* size of a message block processed at once */
-    // unsigned block_size;
 } SHA3_CTX;
 
 #ifdef __cplusplus
@@ -42,8 +41,9 @@ extern "C" {
 #endif /* __cplusplus */
 
 void keccak_init(SHA3_CTX *ctx);
-void keccak_update(SHA3_CTX *ctx, unsigned char *msg, uint16_t size);
+void keccak_update(SHA3_CTX *ctx, const unsigned char *msg, size_t size);
 void keccak_final(SHA3_CTX *ctx, unsigned char *result);
+void keccak256(const unsigned char *msg, size_t size, unsigned char *result);
 
 #ifdef __cplusplus
 }
@@ -52,136 +52,101 @@ void keccak_final(SHA3_CTX *ctx, unsigned char *result);
 // keccak256 implementation
 
 #define BLOCK_SIZE ((1600 - 256 * 2) / 8)
+#define KECCAK256_DIGEST_SIZE 32
 
-#define I64(x) x##LL
 #define ROTL64(qword, n) ((qword) << (n) ^ ((qword) >> (64 - (n))))
 #define le2me_64(x) (x)
 #define IS_ALIGNED_64(p) (0 == (7 & ((const char *)(p) - (const char *)0)))
 #define me64_to_le_str(to, from, length) memcpy((to), (from), (length))
 
-/* constants */
-
-// const uint8_t round_constant_info[] PROGMEM = {
-// const uint8_t constants[] PROGMEM = {
-const uint8_t constants[] = {
-
-    1,
-    26,
-    94,
-    112,
-    31,
-    33,
-    121,
-    85,
-    14,
-    12,
-    53,
-    38,
-    63,
-    79,
-    93,
-    83,
-    82,
-    72,
-    22,
-    102,
-    121,
-    88,
-    33,
-    116,
-    //};
-
-    // const uint8_t pi_transform[] PROGMEM = {
-    1,
-    6,
-    9,
-    22,
-    14,
-    20,
-    2,
-    12,
-    13,
-    19,
-    23,
-    15,
-    4,
-    24,
-    21,
-    8,
-    16,
-    5,
-    3,
-    18,
-    17,
-    11,
-    7,
-    10,
-    //};
-
-    // const uint8_t rhoTransforms[] PROGMEM = {
-    1,
-    62,
-    28,
-    27,
-    36,
-    44,
-    6,
-    55,
-    20,
-    3,
-    10,
-    43,
-    25,
-    39,
-    41,
-    45,
-    15,
-    21,
-    8,
-    18,
-    2,
-    61,
-    56,
-    14,
+static const uint64_t keccak_round_constants[24] = {
+    0x0000000000000001ULL,
+    0x0000000000008082ULL,
+    0x800000000000808AULL,
+    0x8000000080008000ULL,
+    0x000000000000808BULL,
+    0x0000000080000001ULL,
+    0x8000000080008081ULL,
+    0x8000000000008009ULL,
+    0x000000000000008AULL,
+    0x0000000000000088ULL,
+    0x0000000080008009ULL,
+    0x000000008000000AULL,
+    0x000000008000808BULL,
+    0x800000000000008BULL,
+    0x8000000000008089ULL,
+    0x8000000000008003ULL,
+    0x8000000000008002ULL,
+    0x8000000000000080ULL,
+    0x000000000000800AULL,
+    0x800000008000000AULL,
+    0x8000000080008081ULL,
+    0x8000000000008080ULL,
+    0x0000000080000001ULL,
+    0x8000000080008008ULL
 };
 
-#define TYPE_ROUND_INFO 0
-#define TYPE_PI_TRANSFORM 24
-#define TYPE_RHO_TRANSFORM 48
-
-uint8_t getConstant(uint8_t type, uint8_t index) {
-    return constants[type + index];
-    // return pgm_read_byte(&constants[type + index]);
-}
-
-static uint64_t get_round_constant(uint8_t round) {
-    uint64_t result = 0;
+/*
+ * Keccak-f[1600]. Rounds are looped, lanes are unrolled: theta is folded
+ * into the combined rho and pi step, all rotation amounts and lane indexes
+ * are constants.
+ */
+static void sha3_permutation(uint64_t *A) {
+    uint64_t B[25];
+    uint64_t C0, C1, C2, C3, C4, D0, D1, D2, D3, D4;
+
+    for (int round = 0; round < 24; round++) {
+        /* theta */
+        C0 = A[0] ^ A[5] ^ A[10] ^ A[15] ^ A[20];
+        C1 = A[1] ^ A[6] ^ A[11] ^ A[16] ^ A[21];
+        C2 = A[2] ^ A[7] ^ A[12] ^ A[17] ^ A[22];
+        C3 = A[3] ^ A[8] ^ A[13] ^ A[18] ^ A[23];
+        C4 = A[4] ^ A[9] ^ A[14] ^ A[19] ^ A[24];
+        D0 = ROTL64(C1, 1) ^ C4;
+        D1 = ROTL64(C2, 1) ^ C0;
+        D2 = ROTL64(C3, 1) ^ C1;
+        D3 = ROTL64(C4, 1) ^ C2;
+        D4 = ROTL64(C0, 1) ^ C3;
+
+        /* rho and pi: B[y, 2x + 3y] = ROTL64(A[x, y], r[x, y]) */
+        B[0] = A[0] ^ D0;
+        B[1] = ROTL64(A[6] ^ D1, 44);
+        B[2] = ROTL64(A[12] ^ D2, 43);
+        B[3] = ROTL64(A[18] ^ D3, 21);
+        B[4] = ROTL64(A[24] ^ D4, 14);
+        B[5] = ROTL64(A[3] ^ D3, 28);
+        B[6] = ROTL64(A[9] ^ D4, 20);
+        B[7] = ROTL64(A[10] ^ D0, 3);
+        B[8] = ROTL64(A[16] ^ D1, 45);
+        B[9] = ROTL64(A[22] ^ D2, 61);
+        B[10] = ROTL64(A[1] ^ D1, 1);
+        B[11] = ROTL64(A[7] ^ D2, 6);
+        B[12] = ROTL64(A[13] ^ D3, 25);
+        B[13] = ROTL64(A[19] ^ D4, 8);
+        B[14] = ROTL64(A[20] ^ D0, 18);
+        B[15] = ROTL64(A[4] ^ D4, 27);
+        B[16] = ROTL64(A[5] ^ D0, 36);
+        B[17] = ROTL64(A[11] ^ D1, 10);
+        B[18] = ROTL64(A[17] ^ D2, 15);
+        B[19] = ROTL64(A[23] ^ D3, 56);
+        B[20] = ROTL64(A[2] ^ D2, 62);
+        B[21] = ROTL64(A[8] ^ D3, 55);
+        B[22] = ROTL64(A[14] ^ D4, 39);
+        B[23] = ROTL64(A[15] ^ D0, 41);
+        B[24] = ROTL64(A[21] ^ D1, 2);
+
+        /* chi */
+        for (int y = 0; y < 25; y += 5) {
+            A[y + 0] = B[y + 0] ^ (~B[y + 1] & B[y + 2]);
+            A[y + 1] = B[y + 1] ^ (~B[y + 2] & B[y + 3]);
+            A[y + 2] = B[y + 2] ^ (~B[y + 3] & B[y + 4]);
+            A[y + 3] = B[y + 3] ^ (~B[y + 4] & B[y + 0]);
+            A[y + 4] = B[y + 4] ^ (~B[y + 0] & B[y + 1]);
+        }
 
-    // uint8_t roundInfo = pgm_read_byte(&round_constant_info[round]);
-    uint8_t roundInfo = getConstant(TYPE_ROUND_INFO, round);
-    if (roundInfo & (1 << 6)) {
-        result |= ((uint64_t)1 << 63);
-    }
-    if (roundInfo & (1 << 5)) {
-        result |= ((uint64_t)1 << 31);
-    }
-    if (roundInfo & (1 << 4)) {
-        result |= ((uint64_t)1 << 15);
-    }
-    if (roundInfo & (1 << 3)) {
-        result |= ((uint64_t)1 << 7);
-    }
-    if (roundInfo & (1 << 2)) {
-        result |= ((uint64_t)1 << 3);
-    }
-    if (roundInfo & (1 << 1)) {
-        result |= ((uint64_t)1 << 1);
-    }
-    if (roundInfo & (1 << 0)) {
-        result |= ((uint64_t)1 << 0);
+        /* iota */
+        A[0] ^= keccak_round_constants[round];
     }
-
-    return result;
 }
 
 /* Initializing a sha3 context for given number of output bits */
@@ -191,99 +156,35 @@ void keccak_init(SHA3_CTX *ctx) {
     memset(ctx, 0, sizeof(SHA3_CTX));
 }
 
-/* Keccak theta() transformation */
-static void keccak_theta(uint64_t *A) {
-    uint64_t C[5], D[5];
-
-    for (uint8_t i = 0; i < 5; i++) {
-        C[i] = A[i];
-        for (uint8_t j = 5; j < 25; j += 5) {
-            C[i] ^= A[i + j];
-        }
-    }
-
-    for (uint8_t i = 0; i < 5; i++) {
-        D[i] = ROTL64(C[(i + 1) % 5], 1) ^ C[(i + 4) % 5];
-    }
-
-    for (uint8_t i = 0; i < 5; i++) {
-        // for (uint8_t j = 0; j < 25; j += 5) {
-        for (uint8_t j = 0; j < 25; j += 5) {
-            A[i + j] ^= D[i];
-        }
-    }
-}
-
-/* Keccak pi() transformation */
-static void keccak_pi(uint64_t *A) {
-    uint64_t A1 = A[1];
-    // for (uint8_t i = 1; i < sizeof(pi_transform); i++) {
-    for (uint8_t i = 1; i < 24; i++) {
-        // A[pgm_read_byte(&pi_transform[i - 1])] =
-        // A[pgm_read_byte(&pi_transform[i])];
-        A[getConstant(TYPE_PI_TRANSFORM, i - 1)] =
-            A[getConstant(TYPE_PI_TRANSFORM, i)];
-    }
-    A[10] = A1;
-    /* note: A[ 0] is left as is */
-}
-
-/*
-ketch uses 30084 bytes (93%) of program storage space. Maximum is 32256 bytes.
-Global variables use 743 bytes (36%) of dynamic memory, leaving 1305 bytes for
-local variables. Maximum is 2048 bytes.
-*/
-/* Keccak chi() transformation */
-static void keccak_chi(uint64_t *A) {
-    for (uint8_t i = 0; i < 25; i += 5) {
-        uint64_t A0 = A[0 + i], A1 = A[1 + i];
-        A[0 + i] ^= ~A1 & A[2 + i];
-        A[1 + i] ^= ~A[2 + i] & A[3 + i];
-        A[2 + i] ^= ~A[3 + i] & A[4 + i];
-        A[3 + i] ^= ~A[4 + i] & A0;
-        A[4 + i] ^= ~A0 & A1;
-    }
-}
-
-static void sha3_permutation(uint64_t *state) {
-    // for (uint8_t round = 0; round < sizeof(round_constant_info); round++) {
-    for (uint8_t round = 0; round < 24; round++) {
-        keccak_theta(state);
-
-        /* apply Keccak rho() transformation */
-        for (uint8_t i = 1; i < 25; i++) {
-            // state[i] = ROTL64(state[i], pgm_read_byte(&rhoTransforms[i -
-            // 1]));
-            state[i] = ROTL64(state[i], getConstant(TYPE_RHO_TRANSFORM, i - 1));
-        }
-
-        keccak_pi(state);
-        keccak_chi(state);
-
-        /* apply iota(state, round) */
-        *state ^= get_round_constant(round);
-    }
-}
-
 /**
  * The core transformation. Process the specified block of data.
  *
  * @param hash the algorithm state
  * @param block the message block to process
- * @param block_size the size of the processed block in bytes
  */
 static void sha3_process_block(uint64_t hash[25], const uint64_t *block) {
-    for (uint8_t i = 0; i < 17; i++) {
-        hash[i] ^= le2me_64(block[i]);
-    }
+    hash[0] ^= le2me_64(block[0]);
+    hash[1] ^= le2me_64(block[1]);
+    hash[2] ^= le2me_64(block[2]);
+    hash[3] ^= le2me_64(block[3]);
+    hash[4] ^= le2me_64(block[4]);
+    hash[5] ^= le2me_64(block[5]);
+    hash[6] ^= le2me_64(block[6]);
+    hash[7] ^= le2me_64(block[7]);
+    hash[8] ^= le2me_64(block[8]);
+    hash[9] ^= le2me_64(block[9]);
+    hash[10] ^= le2me_64(block[10]);
+    hash[11] ^= le2me_64(block[11]);
+    hash[12] ^= le2me_64(block[12]);
+    hash[13] ^= le2me_64(block[13]);
+    hash[14] ^= le2me_64(block[14]);
+    hash[15] ^= le2me_64(block[15]);
+    hash[16] ^= le2me_64(block[16]);
 
     /* make a permutation of the hash */
     sha3_permutation(hash);
 }
 
-//#define SHA3_FINALIZED 0x80000000
-//#define SHA3_FINALIZED 0x8000
-
 /**
  * Calculate message hash.
  * Can be called repeatedly with chunks of the message to be hashed.
@@ -292,16 +193,14 @@ static void sha3_process_block(uint64_t hash[25], const uint64_t *block) {
  * @param msg message chunk
  * @param size length of the message chunk
  */
-void keccak_update(SHA3_CTX *ctx, unsigned char *msg, uint16_t size) {
-    uint16_t idx = (uint16_t)ctx->rest;
+void keccak_update(SHA3_CTX *ctx, const unsigned char *msg, size_t size) {
+    size_t idx = ctx->rest;
 
-    // if (ctx->rest & SHA3_FINALIZED) return; /* too late for additional input
-    // */
-    ctx->rest = (unsigned)((ctx->rest + size) % BLOCK_SIZE);
+    ctx->rest = (uint16_t)((ctx->rest + size) % BLOCK_SIZE);
 
     /* fill partial block */
     if (idx) {
-        uint16_t left = BLOCK_SIZE - idx;
+        size_t left = BLOCK_SIZE - idx;
         memcpy((char *)ctx->message + idx, msg, (size < left ? size : left));
         if (size < left) return;
 
@@ -312,11 +211,11 @@ void keccak_update(SHA3_CTX *ctx, unsigned char *msg, uint16_t size) {
     }
 
     while (size >= BLOCK_SIZE) {
-        uint64_t *aligned_message_block;
+        const uint64_t *aligned_message_block;
         if (IS_ALIGNED_64(msg)) {
             // the most common case is processing of an already aligned message
             // without copying it
-            aligned_message_block = (uint64_t *)(void *)msg;
+            aligned_message_block = (const uint64_t *)(const void *)msg;
         } else {
             memcpy(ctx->message, msg, BLOCK_SIZE);
             aligned_message_block = ctx->message;
@@ -339,9 +238,6 @@ void keccak_update(SHA3_CTX *ctx, unsigned char *msg, uint16_t size) {
  * @param result calculated hash in binary form
  */
 void keccak_final(SHA3_CTX *ctx, unsigned char *result) {
-    uint16_t digest_length = 100 - BLOCK_SIZE / 2;
-
-    //    if (!(ctx->rest & SHA3_FINALIZED)) {
     /* clear the rest of the data queue */
     memset((char *)ctx->message + ctx->rest, 0, BLOCK_SIZE - ctx->rest);
     ((char *)ctx->message)[ctx->rest] |= 0x01;
@@ -349,12 +245,24 @@ void keccak_final(SHA3_CTX *ctx, unsigned char *result) {
 
     /* process final block */
     sha3_process_block(ctx->hash, ctx->message);
-    //        ctx->rest = SHA3_FINALIZED; /* mark context as finalized */
-    //    }
 
     if (result) {
-        me64_to_le_str(result, ctx->hash, digest_length);
+        me64_to_le_str(result, ctx->hash, KECCAK256_DIGEST_SIZE);
     }
 }
 
+/**
+ * One-shot keccak256 (Ethereum flavor, 0x01 padding).
+ *
+ * @param msg message to hash
+ * @param size length of the message
+ * @param result 32 bytes of output, may overlap msg
+ */
+void keccak256(const unsigned char *msg, size_t size, unsigned char *result) {
+    SHA3_CTX ctx;
+    keccak_init(&ctx);
+    keccak_update(&ctx, msg, size);
+    keccak_final(&ctx, result);
+}
+
 #endif /* __KECCAK256_H_ */
@@ -0,0 +1,50 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "blake2b.h"
+#include "secp256r1/secp256r1_inc.h"
+
+#define ERROR_IO -1
+
+static Secp256r1Affine table[SECP256R1_TABLE_SIZE(SECP256R1_WINDOW_G)];
+
+int main(int argc, char* argv[]) {
+    secp256r1_build_table(table, SECP256R1_WINDOW_G);
+
+    FILE* fp_data = fopen("build/secp256r1_data", "wb");
+    if (!fp_data) {
+        return ERROR_IO;
+    }
+    fwrite(table, sizeof(table), 1, fp_data);
+    fclose(fp_data);
+
+    FILE* fp = fopen("build/secp256r1_data_info.h", "w");
+    if (!fp) {
+        return ERROR_IO;
+    }
+
+    fprintf(fp, "#ifndef CKB_SECP256R1_DATA_INFO_H_\n");
+    fprintf(fp, "#define CKB_SECP256R1_DATA_INFO_H_\n");
+    fprintf(fp, "#define CKB_SECP256R1_DATA_SIZE %ld\n", sizeof(table));
+    fprintf(fp, "#define CKB_SECP256R1_DATA_WINDOW %d\n", SECP256R1_WINDOW_G);
+
+    blake2b_state blake2b_ctx;
+    uint8_t hash[32];
+    blake2b_init(&blake2b_ctx, 32);
+    blake2b_update(&blake2b_ctx, table, sizeof(table));
+    blake2b_final(&blake2b_ctx, hash, 32);
+
+    fprintf(fp, "static uint8_t ckb_secp256r1_data_hash[32] = {\n  ");
+    for (int i = 0; i < 32; i++) {
+        fprintf(fp, "%u", hash[i]);
+        if (i != 31) {
+            fprintf(fp, ", ");
+        }
+    }
+    fprintf(fp, "\n};\n");
+    fprintf(fp, "#endif\n");
+    fclose(fp);
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+#ifndef CKB_ED25519_KEY_CACHE_H_
+#define CKB_ED25519_KEY_CACHE_H_
+
+#include "ge.h"
+#include "sc.h"
+#include "sha512.h"
+
+// precomp_data.h also defines the fixed base table, which isn't used here.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-const-variable"
+#include "precomp_data.h"
+#pragma GCC diagnostic pop
+
+/*
+ * Per-key cache of ed25519 points, shared by Solana, Cardano and Monero.
+ *
+ * Every verification computes [a](-A) + [b]B. The reference
+ * ge_double_scalarmult_vartime decompresses A and builds its odd multiples
+ * -A, -3A, ..., -15A from scratch on each call; when one key signs several
+ * entries of a run, both are done once here and reused. Entries are kept in
+ * a small ring, only for keys that decompressed to a valid point.
+ */
+#define ED25519_KEY_CACHE_SIZE 4
+#define ED25519_ODD_MULTIPLES 8
+
+typedef struct {
+    uint8_t public_key[32];
+    ge_cached odd_multiples[ED25519_ODD_MULTIPLES];
+} Ed25519KeyCacheEntry;
+
+static Ed25519KeyCacheEntry g_ed25519_key_cache[ED25519_KEY_CACHE_SIZE];
+static size_t g_ed25519_key_cache_count = 0;
+
+// Same recoding as slide() in deps/ed25519/src/ge.c, which is static there.
+static void _ed25519_slide(signed char *r, const unsigned char *a) {
+    for (int i = 0; i < 256; ++i) {
+        r[i] = 1 & (a[i >> 3] >> (i & 7));
+    }
+    for (int i = 0; i < 256; ++i) {
+        if (!r[i]) {
+            continue;
+        }
+        for (int b = 1; b <= 6 && i + b < 256; ++b) {
+            if (!r[i + b]) {
+                continue;
+            }
+            if (r[i] + (r[i + b] << b) <= 15) {
+                r[i] += r[i + b] << b;
+                r[i + b] = 0;
+            } else if (r[i] - (r[i + b] << b) >= -15) {
+                r[i] -= r[i + b] << b;
+                for (int k = i + b; k < 256; ++k) {
+                    if (!r[k]) {
+                        r[k] = 1;
+                        break;
+                    }
+                    r[k] = 0;
+                }
+            } else {
+                break;
+            }
+        }
+    }
+}
+
+// Returns the odd multiples of -A for public_key, NULL if it isn't a point.
+static const ge_cached *ed25519_key_odd_multiples(const uint8_t *public_key) {
+    size_t count = g_ed25519_key_cache_count < ED25519_KEY_CACHE_SIZE
+                       ? g_ed25519_key_cache_count
+                       : ED25519_KEY_CACHE_SIZE;
+    for (size_t i = 0; i < count; i++) {
+        if (memcmp(g_ed25519_key_cache[i].public_key, public_key, 32) == 0) {
+            return g_ed25519_key_cache[i].odd_multiples;
+        }
+    }
+
+    ge_p3 a;
+    if (ge_frombytes_negate_vartime(&a, public_key) != 0) {
+        return NULL;
+    }
+    Ed25519KeyCacheEntry *entry =
+        &g_ed25519_key_cache[g_ed25519_key_cache_count %
+                             ED25519_KEY_CACHE_SIZE];
+    g_ed25519_key_cache_count++;
+    memcpy(entry->public_key, public_key, 32);
+
+    ge_p1p1 t;
+    ge_p3 u;
+    ge_p3 a2;
+    ge_p3_to_cached(&entry->odd_multiples[0], &a);
+    ge_p3_dbl(&t, &a);
+    ge_p1p1_to_p3(&a2, &t);
+    for (int i = 1; i < ED25519_ODD_MULTIPLES; i++) {
+        ge_add(&t, &a2, &entry->odd_multiples[i - 1]);
+        ge_p1p1_to_p3(&u, &t);
+        ge_p3_to_cached(&entry->odd_multiples[i], &u);
+    }
+    return entry->odd_multiples;
+}
+
+// ge_double_scalarmult_vartime with the odd multiples of A precomputed.
+static void ed25519_double_scalarmult_cached(ge_p2 *r, const uint8_t *a,
+                                             const ge_cached *ai,
+                                             const uint8_t *b) {
+    signed char aslide[256];
+    signed char bslide[256];
+    ge_p1p1 t;
+    ge_p3 u;
+    int i;
+
+    _ed25519_slide(aslide, a);
+    _ed25519_slide(bslide, b);
+    ge_p2_0(r);
+    for (i = 255; i >= 0; --i) {
+        if (aslide[i] || bslide[i]) break;
+    }
+    for (; i >= 0; --i) {
+        ge_p2_dbl(&t, r);
+        if (aslide[i] > 0) {
+            ge_p1p1_to_p3(&u, &t);
+            ge_add(&t, &u, &ai[aslide[i] / 2]);
+        } else if (aslide[i] < 0) {
+            ge_p1p1_to_p3(&u, &t);
+            ge_sub(&t, &u, &ai[(-aslide[i]) / 2]);
+        }
+        if (bslide[i] > 0) {
+            ge_p1p1_to_p3(&u, &t);
+            ge_madd(&t, &u, &Bi[bslide[i] / 2]);
+        } else if (bslide[i] < 0) {
+            ge_p1p1_to_p3(&u, &t);
+            ge_msub(&t, &u, &Bi[(-bslide[i]) / 2]);
+        }
+        ge_p1p1_to_p2(r, &t);
+    }
+}
+
+// Drop-in for ed25519_verify in deps/ed25519/src/verify.c, returns 1 on a
+// valid signature.
+int ed25519_verify_cached(const unsigned char *signature,
+                          const unsigned char *message, size_t message_len,
+                          const unsigned char *public_key) {
+    unsigned char h[64];
+    unsigned char checker[32];
+    sha512_context hash;
+    ge_p2 r;
+
+    if (signature[63] & 224) {
+        return 0;
+    }
+    const ge_cached *ai = ed25519_key_odd_multiples(public_key);
+    if (ai == NULL) {
+        return 0;
+    }
+
+    sha512_init(&hash);
+    sha512_update(&hash, signature, 32);
+    sha512_update(&hash, public_key, 32);
+    sha512_update(&hash, message, message_len);
+    sha512_final(&hash, h);
+    sc_reduce(h);
+
+    ed25519_double_scalarmult_cached(&r, h, ai, signature + 32);
+    ge_tobytes(checker, &r);
+    return memcmp(checker, signature, 32) == 0;
+}
+
+#endif
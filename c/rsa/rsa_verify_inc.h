@@ -0,0 +1,610 @@
+// RSA public key verification used by AuthAlgorithmIdRsa and
+// AuthAlgorithmIdIso97962.
+//
+// The signature (witness) layout is compatible with the `RsaInfo` structure
+// of ckb-production-scripts' rsa_sighash_all:
+//
+// +--------------+------------------------------------------+---------+
+// | algorithm_id | CKB_VERIFY_RSA or CKB_VERIFY_ISO9796_2   |       1 |
+// | key_size     | 1 = 1024, 2 = 2048, 3 = 4096 bits        |       1 |
+// | padding      | 0 = PKCS#1 v1.5, 1 = PKCS#1 v2.1 (PSS)   |       1 |
+// | md_type      | mbedtls_md_type_t of the message digest  |       1 |
+// | E            | public exponent, little endian           |       4 |
+// | N            | modulus, little endian                   | key/8   |
+// | signature    | big endian, as produced by PKCS#1 signer | key/8   |
+// +--------------+------------------------------------------+---------+
+//
+// The public key operation is done with a small fixed-size Montgomery
+// implementation instead of mbedtls_rsa_pkcs1_verify: mbedtls' bignum
+// allocates on every operation and recomputes R^2 mod N for each call. Here
+// all working memory lives in a static arena, the Montgomery constants of
+// recently used moduli are cached, and the common exponent 65537 is computed
+// with a fixed 16 squarings + 1 multiplication chain.
+#include "mbedtls/md.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha512.h"
+
+#define CKB_VERIFY_RSA 1
+#define CKB_VERIFY_ISO9796_2 2
+
+#define CKB_KEY_SIZE_1024 1
+#define CKB_KEY_SIZE_2048 2
+#define CKB_KEY_SIZE_4096 3
+
+#define CKB_PKCS_15 0
+#define CKB_PKCS_21 1
+
+#define RSA_INFO_HEADER_SIZE 8
+#define RSA_MAX_KEY_BYTES 512
+#define RSA_MAX_LIMBS (RSA_MAX_KEY_BYTES / 8)
+#define RSA_MAX_MD_SIZE 64
+#define RSA_PUBLIC_EXPONENT_F4 65537
+// Number of distinct moduli whose Montgomery constants are kept per run.
+#define RSA_MONT_CACHE_SIZE 2
+
+enum RsaErrorCodeType {
+    RsaSuccess = 0,
+    RsaErr_InvalidParam = 230,
+    RsaErr_InvalidKey,
+    RsaErr_InvalidSignature,
+    RsaErr_UnsupportedMd,
+    RsaErr_Md,
+};
+
+typedef struct RsaInfo {
+    uint8_t algorithm_id;
+    uint8_t key_size;
+    uint8_t padding;
+    uint8_t md_type;
+    uint8_t E[4];
+    uint8_t N[];
+} RsaInfo;
+
+typedef struct RsaMontCtx {
+    size_t n;     // number of 64-bit limbs, 0 for an unused cache slot
+    uint64_t mm;  // -N^-1 mod 2^64
+    uint64_t N[RSA_MAX_LIMBS];
+    uint64_t RR[RSA_MAX_LIMBS];  // R^2 mod N, R = 2^(64 * n)
+} RsaMontCtx;
+
+static RsaMontCtx g_rsa_mont_cache[RSA_MONT_CACHE_SIZE];
+static size_t g_rsa_mont_cache_next = 0;
+
+// Working memory of the public key operation. It is static rather than on
+// the stack so a 4096-bit verification costs no more stack than a 1024-bit
+// one, and no allocator is involved at all.
+static struct {
+    uint64_t s[RSA_MAX_LIMBS];  // signature
+    uint64_t x[RSA_MAX_LIMBS];  // accumulator
+    uint64_t y[RSA_MAX_LIMBS];  // signature in Montgomery form
+    uint64_t t[RSA_MAX_LIMBS + 2];
+    uint8_t em[RSA_MAX_KEY_BYTES];  // encoded message, big endian
+} g_rsa_arena;
+
+typedef struct RsaMdContext {
+    uint8_t md_type;
+    union {
+        mbedtls_sha1_context sha1;
+        mbedtls_sha256_context sha256;
+        mbedtls_sha512_context sha512;
+    } u;
+} RsaMdContext;
+
+size_t get_rsa_key_bytes(uint8_t key_size) {
+    switch (key_size) {
+        case CKB_KEY_SIZE_1024:
+            return 1024 / 8;
+        case CKB_KEY_SIZE_2048:
+            return 2048 / 8;
+        case CKB_KEY_SIZE_4096:
+            return 4096 / 8;
+        default:
+            return 0;
+    }
+}
+
+// Length of the whole signature field: header, N and the signature itself.
+size_t calculate_rsa_info_length(size_t key_bytes) {
+    return RSA_INFO_HEADER_SIZE + key_bytes * 2;
+}
+
+static size_t rsa_md_size(uint8_t md_type) {
+    switch (md_type) {
+        case MBEDTLS_MD_SHA1:
+            return 20;
+        case MBEDTLS_MD_SHA256:
+            return 32;
+        case MBEDTLS_MD_SHA384:
+            return 48;
+        case MBEDTLS_MD_SHA512:
+            return 64;
+        default:
+            return 0;
+    }
+}
+
+static int rsa_md_starts(RsaMdContext *ctx, uint8_t md_type) {
+    ctx->md_type = md_type;
+    switch (md_type) {
+        case MBEDTLS_MD_SHA1:
+            mbedtls_sha1_init(&ctx->u.sha1);
+            return mbedtls_sha1_starts_ret(&ctx->u.sha1);
+        case MBEDTLS_MD_SHA256:
+            mbedtls_sha256_init(&ctx->u.sha256);
+            return mbedtls_sha256_starts_ret(&ctx->u.sha256, 0);
+        case MBEDTLS_MD_SHA384:
+        case MBEDTLS_MD_SHA512:
+            mbedtls_sha512_init(&ctx->u.sha512);
+            return mbedtls_sha512_starts_ret(&ctx->u.sha512,
+                                             md_type == MBEDTLS_MD_SHA384);
+        default:
+            return RsaErr_UnsupportedMd;
+    }
+}
+
+static int rsa_md_update(RsaMdContext *ctx, const uint8_t *buf, size_t len) {
+    switch (ctx->md_type) {
+        case MBEDTLS_MD_SHA1:
+            return mbedtls_sha1_update_ret(&ctx->u.sha1, buf, len);
+        case MBEDTLS_MD_SHA256:
+            return mbedtls_sha256_update_ret(&ctx->u.sha256, buf, len);
+        case MBEDTLS_MD_SHA384:
+        case MBEDTLS_MD_SHA512:
+            return mbedtls_sha512_update_ret(&ctx->u.sha512, buf, len);
+        default:
+            return RsaErr_UnsupportedMd;
+    }
+}
+
+static int rsa_md_finish(RsaMdContext *ctx, uint8_t *output) {
+    switch (ctx->md_type) {
+        case MBEDTLS_MD_SHA1:
+            return mbedtls_sha1_finish_ret(&ctx->u.sha1, output);
+        case MBEDTLS_MD_SHA256:
+            return mbedtls_sha256_finish_ret(&ctx->u.sha256, output);
+        case MBEDTLS_MD_SHA384:
+        case MBEDTLS_MD_SHA512:
+            return mbedtls_sha512_finish_ret(&ctx->u.sha512, output);
+        default:
+            return RsaErr_UnsupportedMd;
+    }
+}
+
+static int rsa_md(uint8_t md_type, const uint8_t *buf, size_t len,
+                  uint8_t *output) {
+    RsaMdContext ctx;
+    int err = rsa_md_starts(&ctx, md_type);
+    if (err != 0) return err;
+    err = rsa_md_update(&ctx, buf, len);
+    if (err != 0) return err;
+    return rsa_md_finish(&ctx, output);
+}
+
+static int rsa_limbs_cmp(const uint64_t *a, const uint64_t *b, size_t n) {
+    for (size_t i = n; i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] > b[i] ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+// r = a - b, returns the borrow. r may alias a or b.
+static uint64_t rsa_limbs_sub(uint64_t *r, const uint64_t *a,
+                              const uint64_t *b, size_t n) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t ai = a[i];
+        uint64_t d = ai - b[i];
+        uint64_t b1 = ai < b[i];
+        r[i] = d - borrow;
+        borrow = b1 | (d < borrow);
+    }
+    return borrow;
+}
+
+// Montgomery multiplication (CIOS): r = a * b / R mod N. r may alias a or b.
+static void rsa_mont_mul(uint64_t *r, const uint64_t *a, const uint64_t *b,
+                         const RsaMontCtx *ctx) {
+    size_t n = ctx->n;
+    const uint64_t *N = ctx->N;
+    uint64_t *t = g_rsa_arena.t;
+    memset(t, 0, (n + 2) * sizeof(uint64_t));
+
+    for (size_t i = 0; i < n; i++) {
+        __uint128_t p;
+        uint64_t c = 0;
+        uint64_t ai = a[i];
+        for (size_t j = 0; j < n; j++) {
+            p = (__uint128_t)ai * b[j] + t[j] + c;
+            t[j] = (uint64_t)p;
+            c = (uint64_t)(p >> 64);
+        }
+        p = (__uint128_t)t[n] + c;
+        t[n] = (uint64_t)p;
+        t[n + 1] = (uint64_t)(p >> 64);
+
+        uint64_t u = t[0] * ctx->mm;
+        p = (__uint128_t)u * N[0] + t[0];
+        c = (uint64_t)(p >> 64);
+        for (size_t j = 1; j < n; j++) {
+            p = (__uint128_t)u * N[j] + t[j] + c;
+            t[j - 1] = (uint64_t)p;
+            c = (uint64_t)(p >> 64);
+        }
+        p = (__uint128_t)t[n] + c;
+        t[n - 1] = (uint64_t)p;
+        t[n] = t[n + 1] + (uint64_t)(p >> 64);
+    }
+
+    if (t[n] != 0 || rsa_limbs_cmp(t, N, n) >= 0) {
+        rsa_limbs_sub(r, t, N, n);
+    } else {
+        memcpy(r, t, n * sizeof(uint64_t));
+    }
+}
+
+// Fill the Montgomery constants of ctx->N. N must be odd with its top bit
+// set, so that R / 2 < N < R.
+static void rsa_mont_ctx_init(RsaMontCtx *ctx) {
+    size_t n = ctx->n;
+    const uint64_t *N = ctx->N;
+
+    // Newton iteration, every step doubles the number of correct low bits:
+    // N * N = 1 (mod 8) for odd N.
+    uint64_t inv = N[0];
+    for (int i = 0; i < 5; i++) {
+        inv *= 2 - N[0] * inv;
+    }
+    ctx->mm = (uint64_t)0 - inv;
+
+    // R mod N = R - N
+    uint64_t *x = ctx->RR;
+    memset(x, 0, n * sizeof(uint64_t));
+    rsa_limbs_sub(x, x, N, n);
+    // 64 doublings: x = R * 2^64 mod N
+    for (int i = 0; i < 64; i++) {
+        uint64_t carry = x[n - 1] >> 63;
+        for (size_t j = n - 1; j > 0; j--) {
+            x[j] = (x[j] << 1) | (x[j - 1] >> 63);
+        }
+        x[0] <<= 1;
+        if (carry || rsa_limbs_cmp(x, N, n) >= 0) {
+            rsa_limbs_sub(x, x, N, n);
+        }
+    }
+    // Each Montgomery squaring doubles the exponent above R:
+    // R * 2^(64 * 2^k). n is a power of two, so log2(n) squarings yield R^2.
+    for (size_t k = n; k > 1; k >>= 1) {
+        rsa_mont_mul(x, x, x, ctx);
+    }
+}
+
+static const RsaMontCtx *rsa_mont_ctx_get(const uint8_t *n_le,
+                                          size_t key_bytes) {
+    size_t n = key_bytes / 8;
+    uint64_t *limbs = g_rsa_arena.x;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t v = 0;
+        for (int j = 7; j >= 0; j--) {
+            v = (v << 8) | n_le[i * 8 + j];
+        }
+        limbs[i] = v;
+    }
+
+    for (size_t i = 0; i < RSA_MONT_CACHE_SIZE; i++) {
+        RsaMontCtx *ctx = &g_rsa_mont_cache[i];
+        if (ctx->n == n && memcmp(ctx->N, limbs, n * sizeof(uint64_t)) == 0) {
+            return ctx;
+        }
+    }
+
+    RsaMontCtx *ctx = &g_rsa_mont_cache[g_rsa_mont_cache_next];
+    g_rsa_mont_cache_next = (g_rsa_mont_cache_next + 1) % RSA_MONT_CACHE_SIZE;
+    ctx->n = n;
+    memcpy(ctx->N, limbs, n * sizeof(uint64_t));
+    rsa_mont_ctx_init(ctx);
+    return ctx;
+}
+
+// Raw public key operation: g_rsa_arena.em = sig ^ E mod N, big endian.
+int rsa_public_op(const RsaInfo *info, size_t key_bytes, const uint8_t *sig) {
+    uint32_t e = (uint32_t)info->E[0] | ((uint32_t)info->E[1] << 8) |
+                 ((uint32_t)info->E[2] << 16) | ((uint32_t)info->E[3] << 24);
+    if (e < 3 || (e & 1) == 0) {
+        return RsaErr_InvalidKey;
+    }
+    if ((info->N[0] & 1) == 0 || (info->N[key_bytes - 1] & 0x80) == 0) {
+        return RsaErr_InvalidKey;
+    }
+
+    const RsaMontCtx *ctx = rsa_mont_ctx_get(info->N, key_bytes);
+    size_t n = ctx->n;
+    uint64_t *s = g_rsa_arena.s;
+    uint64_t *x = g_rsa_arena.x;
+    uint64_t *y = g_rsa_arena.y;
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t v = 0;
+        const uint8_t *p = sig + key_bytes - (i + 1) * 8;
+        for (int j = 0; j < 8; j++) {
+            v = (v << 8) | p[j];
+        }
+        s[i] = v;
+    }
+    if (rsa_limbs_cmp(s, ctx->N, n) >= 0) {
+        return RsaErr_InvalidSignature;
+    }
+
+    // y = s * R mod N
+    rsa_mont_mul(y, s, ctx->RR, ctx);
+    memcpy(x, y, n * sizeof(uint64_t));
+    if (e == RSA_PUBLIC_EXPONENT_F4) {
+        for (int i = 0; i < 16; i++) {
+            rsa_mont_mul(x, x, x, ctx);
+        }
+    } else {
+        int top = 31;
+        while (((e >> top) & 1) == 0) {
+            top--;
+        }
+        for (int i = top - 1; i > 0; i--) {
+            rsa_mont_mul(x, x, x, ctx);
+            if ((e >> i) & 1) {
+                rsa_mont_mul(x, x, y, ctx);
+            }
+        }
+        rsa_mont_mul(x, x, x, ctx);
+    }
+    // E is odd, so the last multiplication is always by s. Multiplying the
+    // Montgomery form by the plain s also leaves the Montgomery domain.
+    rsa_mont_mul(x, x, s, ctx);
+
+    uint8_t *em = g_rsa_arena.em;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t v = x[i];
+        uint8_t *p = em + key_bytes - (i + 1) * 8;
+        for (int j = 7; j >= 0; j--) {
+            p[j] = (uint8_t)v;
+            v >>= 8;
+        }
+    }
+    return RsaSuccess;
+}
+
+static const uint8_t *rsa_digest_info_prefix(uint8_t md_type, size_t *len) {
+    // DER encoded DigestInfo without the digest, see RFC 8017 section 9.2
+    static const uint8_t SHA256_PREFIX[] = {
+        0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+        0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20};
+    static const uint8_t SHA384_PREFIX[] = {
+        0x30, 0x41, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+        0x65, 0x03, 0x04, 0x02, 0x02, 0x05, 0x00, 0x04, 0x30};
+    static const uint8_t SHA512_PREFIX[] = {
+        0x30, 0x51, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+        0x65, 0x03, 0x04, 0x02, 0x03, 0x05, 0x00, 0x04, 0x40};
+    switch (md_type) {
+        case MBEDTLS_MD_SHA256:
+            *len = sizeof(SHA256_PREFIX);
+            return SHA256_PREFIX;
+        case MBEDTLS_MD_SHA384:
+            *len = sizeof(SHA384_PREFIX);
+            return SHA384_PREFIX;
+        case MBEDTLS_MD_SHA512:
+            *len = sizeof(SHA512_PREFIX);
+            return SHA512_PREFIX;
+        default:
+            *len = 0;
+            return NULL;
+    }
+}
+
+// EMSA-PKCS1-v1_5: 0x00 || 0x01 || 0xFF... || 0x00 || DigestInfo || H
+static int rsa_pkcs1_v15_check(const uint8_t *em, size_t key_bytes,
+                               uint8_t md_type, const uint8_t *hash,
+                               size_t hash_len) {
+    size_t prefix_len = 0;
+    const uint8_t *prefix = rsa_digest_info_prefix(md_type, &prefix_len);
+    if (prefix == NULL) return RsaErr_UnsupportedMd;
+
+    size_t t_len = prefix_len + hash_len;
+    if (key_bytes < t_len + 11) return RsaErr_InvalidSignature;
+    if (em[0] != 0x00 || em[1] != 0x01) return RsaErr_InvalidSignature;
+    size_t ps_end = key_bytes - t_len - 1;
+    for (size_t i = 2; i < ps_end; i++) {
+        if (em[i] != 0xFF) return RsaErr_InvalidSignature;
+    }
+    if (em[ps_end] != 0x00) return RsaErr_InvalidSignature;
+    if (memcmp(em + ps_end + 1, prefix, prefix_len) != 0 ||
+        memcmp(em + ps_end + 1 + prefix_len, hash, hash_len) != 0) {
+        return RsaErr_InvalidSignature;
+    }
+    return RsaSuccess;
+}
+
+// XOR MGF1(seed) into buf in place.
+static int rsa_mgf1_xor(uint8_t md_type, const uint8_t *seed, size_t seed_len,
+                        uint8_t *buf, size_t len) {
+    int err = 0;
+    uint8_t mask[RSA_MAX_MD_SIZE];
+    size_t hash_len = rsa_md_size(md_type);
+    uint32_t counter = 0;
+    for (size_t offset = 0; offset < len; offset += hash_len, counter++) {
+        uint8_t c[4] = {(uint8_t)(counter >> 24), (uint8_t)(counter >> 16),
+                        (uint8_t)(counter >> 8), (uint8_t)counter};
+        RsaMdContext ctx;
+        err = rsa_md_starts(&ctx, md_type);
+        if (err != 0) return err;
+        err = rsa_md_update(&ctx, seed, seed_len);
+        if (err != 0) return err;
+        err = rsa_md_update(&ctx, c, sizeof(c));
+        if (err != 0) return err;
+        err = rsa_md_finish(&ctx, mask);
+        if (err != 0) return err;
+
+        size_t chunk = len - offset < hash_len ? len - offset : hash_len;
+        for (size_t i = 0; i < chunk; i++) {
+            buf[offset + i] ^= mask[i];
+        }
+    }
+    return RsaSuccess;
+}
+
+// EMSA-PSS-VERIFY (RFC 8017 section 9.1.2) with MGF1 using the same digest
+// and any salt length. The modulus is a full key_bytes * 8 bits, so emLen is
+// key_bytes and only the top bit of em is unused. DB is unmasked in place.
+static int rsa_pss_check(uint8_t *em, size_t key_bytes, uint8_t md_type,
+                         const uint8_t *hash, size_t hash_len) {
+    int err = 0;
+    if (key_bytes < hash_len + 2) return RsaErr_InvalidSignature;
+    if (em[key_bytes - 1] != 0xBC || (em[0] & 0x80) != 0) {
+        return RsaErr_InvalidSignature;
+    }
+    size_t db_len = key_bytes - hash_len - 1;
+    uint8_t *h = em + db_len;
+    err = rsa_mgf1_xor(md_type, h, hash_len, em, db_len);
+    if (err != 0) return err;
+    em[0] &= 0x7F;
+
+    size_t i = 0;
+    while (i < db_len && em[i] == 0) {
+        i++;
+    }
+    if (i == db_len || em[i] != 0x01) return RsaErr_InvalidSignature;
+    i++;
+
+    static const uint8_t zeros[8] = {0};
+    uint8_t h2[RSA_MAX_MD_SIZE];
+    RsaMdContext ctx;
+    err = rsa_md_starts(&ctx, md_type);
+    if (err != 0) return err;
+    err = rsa_md_update(&ctx, zeros, sizeof(zeros));
+    if (err != 0) return err;
+    err = rsa_md_update(&ctx, hash, hash_len);
+    if (err != 0) return err;
+    err = rsa_md_update(&ctx, em + i, db_len - i);
+    if (err != 0) return err;
+    err = rsa_md_finish(&ctx, h2);
+    if (err != 0) return err;
+
+    if (memcmp(h, h2, hash_len) != 0) return RsaErr_InvalidSignature;
+    return RsaSuccess;
+}
+
+// Verify an RSA signature over msg. The length of the whole RsaInfo must
+// have been checked by the caller against calculate_rsa_info_length().
+int rsa_verify(const RsaInfo *info, const uint8_t *msg, size_t msg_len) {
+    int err = 0;
+    size_t key_bytes = get_rsa_key_bytes(info->key_size);
+    if (info->algorithm_id != CKB_VERIFY_RSA || key_bytes == 0) {
+        return RsaErr_InvalidParam;
+    }
+    // SHA-1 is only accepted by ISO 9796-2, for legacy smart cards
+    size_t hash_len = rsa_md_size(info->md_type);
+    if (hash_len == 0 || info->md_type == MBEDTLS_MD_SHA1) {
+        return RsaErr_UnsupportedMd;
+    }
+
+    uint8_t hash[RSA_MAX_MD_SIZE];
+    err = rsa_md(info->md_type, msg, msg_len, hash);
+    if (err != 0) return RsaErr_Md;
+
+    err = rsa_public_op(info, key_bytes, info->N + key_bytes);
+    if (err != 0) return err;
+
+    if (info->padding == CKB_PKCS_15) {
+        return rsa_pkcs1_v15_check(g_rsa_arena.em, key_bytes, info->md_type,
+                                   hash, hash_len);
+    } else if (info->padding == CKB_PKCS_21) {
+        return rsa_pss_check(g_rsa_arena.em, key_bytes, info->md_type, hash,
+                             hash_len);
+    } else {
+        return RsaErr_InvalidParam;
+    }
+}
+
+// Trailer field of ISO/IEC 9796-2 with an explicit hash identifier.
+static uint16_t iso97962_trailer(uint8_t md_type) {
+    switch (md_type) {
+        case MBEDTLS_MD_SHA1:
+            return 0x33CC;
+        case MBEDTLS_MD_SHA256:
+            return 0x34CC;
+        case MBEDTLS_MD_SHA512:
+            return 0x35CC;
+        case MBEDTLS_MD_SHA384:
+            return 0x36CC;
+        default:
+            return 0;
+    }
+}
+
+// Verify an ISO/IEC 9796-2 scheme 1 signature with message recovery, as
+// produced by smart cards and BouncyCastle's ISO9796d2Signer:
+//
+// header | padding (0xBB.. 0xBA) | M1 | H(M) | trailer (0xBC or 0x??CC)
+//
+// The header's low nibble tells whether padding is present (0xB) or not
+// (0xA); bit 0x20 marks partial recovery, where M1 is only a prefix of M
+// and the rest is supplied by the verifier. Here M is the message, so the
+// recovered M1 is compared against it in place in the arena and H(M) is
+// computed over the message directly: nothing is copied out of the
+// recovered block.
+int iso97962_verify(const RsaInfo *info, const uint8_t *msg, size_t msg_len) {
+    int err = 0;
+    size_t key_bytes = get_rsa_key_bytes(info->key_size);
+    if (info->algorithm_id != CKB_VERIFY_ISO9796_2 || key_bytes == 0) {
+        return RsaErr_InvalidParam;
+    }
+    size_t hash_len = rsa_md_size(info->md_type);
+    uint16_t trailer = iso97962_trailer(info->md_type);
+    if (hash_len == 0 || trailer == 0) return RsaErr_UnsupportedMd;
+
+    err = rsa_public_op(info, key_bytes, info->N + key_bytes);
+    if (err != 0) return err;
+    const uint8_t *em = g_rsa_arena.em;
+
+    if ((em[0] & 0xC0) != 0x40) return RsaErr_InvalidSignature;
+
+    size_t delta = 0;
+    if (em[key_bytes - 1] == 0xBC) {
+        delta = 1;
+    } else if ((((uint16_t)em[key_bytes - 2] << 8) | em[key_bytes - 1]) ==
+               trailer) {
+        delta = 2;
+    } else {
+        return RsaErr_InvalidSignature;
+    }
+
+    size_t m_start = 0;
+    if ((em[0] & 0x0F) == 0x0A) {
+        m_start = 1;
+    } else if ((em[0] & 0x0F) == 0x0B) {
+        size_t i = 1;
+        while (i < key_bytes && em[i] == 0xBB) {
+            i++;
+        }
+        if (i == key_bytes || em[i] != 0xBA) return RsaErr_InvalidSignature;
+        m_start = i + 1;
+    } else {
+        return RsaErr_InvalidSignature;
+    }
+    if (key_bytes < m_start + hash_len + delta) return RsaErr_InvalidSignature;
+
+    size_t hash_offset = key_bytes - delta - hash_len;
+    size_t m1_len = hash_offset - m_start;
+    bool partial = (em[0] & 0x20) != 0;
+    if (partial ? m1_len >= msg_len : m1_len != msg_len) {
+        return RsaErr_InvalidSignature;
+    }
+    if (memcmp(em + m_start, msg, m1_len) != 0) return RsaErr_InvalidSignature;
+
+    uint8_t hash[RSA_MAX_MD_SIZE];
+    err = rsa_md(info->md_type, msg, msg_len, hash);
+    if (err != 0) return RsaErr_Md;
+    if (memcmp(em + hash_offset, hash, hash_len) != 0) {
+        return RsaErr_InvalidSignature;
+    }
+    return RsaSuccess;
+}
@@ -0,0 +1,252 @@
+#ifndef CKB_SECP256K1_FIELD_5X52_CKBVM_IMPL_H_
+#define CKB_SECP256K1_FIELD_5X52_CKBVM_IMPL_H_
+
+/*
+ * secp256k1_fe_mul_inner/secp256k1_fe_sqr_inner for CKB-VM, replacing
+ * field_5x52_int128_impl.h of secp256k1. Include it before secp256k1.c
+ * (see secp256k1_helper_20210801.h), it takes over the include guard of the
+ * upstream file.
+ *
+ * Same reduction steps as upstream, with every 128-bit accumulator kept as
+ * two 64-bit words. gcc expands a uint128_t multiply-accumulate to
+ * mul/mulhu/add/sltu/add/add in whatever order it likes; here the sequences
+ * are written so that CKB-VM fuses them into macro-ops:
+ *
+ *   mulhu h, a, b; mul l, a, b                     -> WIDE_MULU
+ *   add r0, r1, r0; sltu r1, r0, r1; add r2, r2, r1 -> ADC
+ *
+ * which makes a product-and-accumulate cost about as much as one multiply.
+ */
+
+#include "util.h"
+
+#define SECP256K1_FIELD_INNER5X52_IMPL_H
+
+#if defined(__riscv)
+/* (h, l) = a * b */
+#define CKBVM_MUL(h, l, a, b)                                      \
+    __asm__("mulhu %0, %2, %3\n\t"                                 \
+            "mul %1, %2, %3"                                       \
+            : "=&r"(h), "=&r"(l)                                   \
+            : "r"(a), "r"(b))
+
+/* (h, l) += a * b */
+#define CKBVM_MULADD(h, l, a, b)                                   \
+    do {                                                           \
+        uint64_t _th, _tl;                                         \
+        __asm__("mulhu %0, %4, %5\n\t"                             \
+                "mul %1, %4, %5\n\t"                               \
+                "add %2, %1, %2\n\t"                               \
+                "sltu %1, %2, %1\n\t"                              \
+                "add %0, %0, %1\n\t"                               \
+                "add %3, %3, %0"                                   \
+                : "=&r"(_th), "=&r"(_tl), "+r"(l), "+r"(h)         \
+                : "r"(a), "r"(b));                                 \
+    } while (0)
+#else
+#define CKBVM_MUL(h, l, a, b)                                      \
+    do {                                                           \
+        unsigned __int128 _t = (unsigned __int128)(a) * (b);       \
+        (h) = (uint64_t)(_t >> 64);                                \
+        (l) = (uint64_t)_t;                                        \
+    } while (0)
+
+#define CKBVM_MULADD(h, l, a, b)                                   \
+    do {                                                           \
+        unsigned __int128 _t = ((unsigned __int128)(h) << 64) | (l); \
+        _t += (unsigned __int128)(a) * (b);                        \
+        (h) = (uint64_t)(_t >> 64);                                \
+        (l) = (uint64_t)_t;                                        \
+    } while (0)
+#endif
+
+/* (h, l) += x */
+#define CKBVM_ADD(h, l, x) \
+    do {                   \
+        (l) += (x);        \
+        (h) += (l) < (x);  \
+    } while (0)
+
+/* (h, l) >>= 52 */
+#define CKBVM_SHR52(h, l)                \
+    do {                                 \
+        (l) = ((l) >> 52) | ((h) << 12); \
+        (h) >>= 52;                      \
+    } while (0)
+
+SECP256K1_INLINE static void secp256k1_fe_mul_inner(
+    uint64_t *r, const uint64_t *a, const uint64_t *SECP256K1_RESTRICT b) {
+    uint64_t ch, cl, dh, dl;
+    uint64_t t3, t4, tx, u0;
+    uint64_t a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3], a4 = a[4];
+    const uint64_t M = 0xFFFFFFFFFFFFFULL, R = 0x1000003D10ULL;
+
+    VERIFY_BITS(a[0], 56);
+    VERIFY_BITS(a[1], 56);
+    VERIFY_BITS(a[2], 56);
+    VERIFY_BITS(a[3], 56);
+    VERIFY_BITS(a[4], 52);
+    VERIFY_BITS(b[0], 56);
+    VERIFY_BITS(b[1], 56);
+    VERIFY_BITS(b[2], 56);
+    VERIFY_BITS(b[3], 56);
+    VERIFY_BITS(b[4], 52);
+    VERIFY_CHECK(r != b);
+    VERIFY_CHECK(a != b);
+
+    /* [d 0 0 0] = [p3 0 0 0] */
+    CKBVM_MUL(dh, dl, a0, b[3]);
+    CKBVM_MULADD(dh, dl, a1, b[2]);
+    CKBVM_MULADD(dh, dl, a2, b[1]);
+    CKBVM_MULADD(dh, dl, a3, b[0]);
+    /* [c 0 0 0 0 d 0 0 0] = [p8 0 0 0 0 p3 0 0 0] */
+    CKBVM_MUL(ch, cl, a4, b[4]);
+    CKBVM_MULADD(dh, dl, cl & M, R);
+    CKBVM_SHR52(ch, cl);
+    /* [c 0 0 0 0 d t3 0 0 0] = [p8 0 0 0 0 p3 0 0 0], c < 2^60 */
+    t3 = dl & M;
+    CKBVM_SHR52(dh, dl);
+
+    /* [c 0 0 0 0 d t3 0 0 0] = [p8 0 0 0 p4 p3 0 0 0] */
+    CKBVM_MULADD(dh, dl, a0, b[4]);
+    CKBVM_MULADD(dh, dl, a1, b[3]);
+    CKBVM_MULADD(dh, dl, a2, b[2]);
+    CKBVM_MULADD(dh, dl, a3, b[1]);
+    CKBVM_MULADD(dh, dl, a4, b[0]);
+    /* [d t3 0 0 0] = [p8 0 0 0 p4 p3 0 0 0] */
+    CKBVM_MULADD(dh, dl, cl, R);
+    /* [d t4+(tx<<48) t3 0 0 0] = [p8 0 0 0 p4 p3 0 0 0] */
+    t4 = dl & M;
+    CKBVM_SHR52(dh, dl);
+    tx = (t4 >> 48);
+    t4 &= (M >> 4);
+
+    /* [d t4+(tx<<48) t3 0 0 c] = [p8 0 0 p5 p4 p3 0 0 p0] */
+    CKBVM_MUL(ch, cl, a0, b[0]);
+    CKBVM_MULADD(dh, dl, a1, b[4]);
+    CKBVM_MULADD(dh, dl, a2, b[3]);
+    CKBVM_MULADD(dh, dl, a3, b[2]);
+    CKBVM_MULADD(dh, dl, a4, b[1]);
+    /* [d 0 t4+(u0<<48) t3 0 0 c] = [p8 0 0 p5 p4 p3 0 0 p0] */
+    u0 = dl & M;
+    CKBVM_SHR52(dh, dl);
+    u0 = (u0 << 4) | tx;
+    /* [d 0 t4 t3 0 c r0] = [p8 0 0 p5 p4 p3 0 0 p0] */
+    CKBVM_MULADD(ch, cl, u0, R >> 4);
+    r[0] = cl & M;
+    CKBVM_SHR52(ch, cl);
+
+    /* [d 0 t4 t3 0 c r0] = [p8 0 p6 p5 p4 p3 0 p1 p0] */
+    CKBVM_MULADD(ch, cl, a0, b[1]);
+    CKBVM_MULADD(ch, cl, a1, b[0]);
+    CKBVM_MULADD(dh, dl, a2, b[4]);
+    CKBVM_MULADD(dh, dl, a3, b[3]);
+    CKBVM_MULADD(dh, dl, a4, b[2]);
+    /* [d 0 0 t4 t3 c r1 r0] = [p8 0 p6 p5 p4 p3 0 p1 p0] */
+    CKBVM_MULADD(ch, cl, dl & M, R);
+    CKBVM_SHR52(dh, dl);
+    r[1] = cl & M;
+    CKBVM_SHR52(ch, cl);
+
+    /* [d 0 0 t4 t3 c r1 r0] = [p8 p7 p6 p5 p4 p3 p2 p1 p0] */
+    CKBVM_MULADD(ch, cl, a0, b[2]);
+    CKBVM_MULADD(ch, cl, a1, b[1]);
+    CKBVM_MULADD(ch, cl, a2, b[0]);
+    CKBVM_MULADD(dh, dl, a3, b[4]);
+    CKBVM_MULADD(dh, dl, a4, b[3]);
+    /* [d 0 0 0 t4 t3+c r2 r1 r0] = [p8 p7 p6 p5 p4 p3 p2 p1 p0] */
+    CKBVM_MULADD(ch, cl, dl & M, R);
+    CKBVM_SHR52(dh, dl);
+    r[2] = cl & M;
+    CKBVM_SHR52(ch, cl);
+
+    /* [t4+c r3 r2 r1 r0] = [p8 p7 p6 p5 p4 p3 p2 p1 p0], d < 2^62 */
+    CKBVM_MULADD(ch, cl, dl, R);
+    CKBVM_ADD(ch, cl, t3);
+    r[3] = cl & M;
+    CKBVM_SHR52(ch, cl);
+    /* [r4 r3 r2 r1 r0] = [p8 p7 p6 p5 p4 p3 p2 p1 p0], c < 2^48 */
+    r[4] = cl + t4;
+}
+
+SECP256K1_INLINE static void secp256k1_fe_sqr_inner(uint64_t *r,
+                                                    const uint64_t *a) {
+    uint64_t ch, cl, dh, dl;
+    uint64_t t3, t4, tx, u0;
+    uint64_t a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3], a4 = a[4];
+    const uint64_t M = 0xFFFFFFFFFFFFFULL, R = 0x1000003D10ULL;
+
+    VERIFY_BITS(a[0], 56);
+    VERIFY_BITS(a[1], 56);
+    VERIFY_BITS(a[2], 56);
+    VERIFY_BITS(a[3], 56);
+    VERIFY_BITS(a[4], 52);
+
+    /* [d 0 0 0] = [p3 0 0 0] */
+    CKBVM_MUL(dh, dl, a0 * 2, a3);
+    CKBVM_MULADD(dh, dl, a1 * 2, a2);
+    /* [c 0 0 0 0 d 0 0 0] = [p8 0 0 0 0 p3 0 0 0] */
+    CKBVM_MUL(ch, cl, a4, a4);
+    CKBVM_MULADD(dh, dl, cl & M, R);
+    CKBVM_SHR52(ch, cl);
+    /* [c 0 0 0 0 d t3 0 0 0] = [p8 0 0 0 0 p3 0 0 0], c < 2^60 */
+    t3 = dl & M;
+    CKBVM_SHR52(dh, dl);
+
+    /* [c 0 0 0 0 d t3 0 0 0] = [p8 0 0 0 p4 p3 0 0 0] */
+    a4 *= 2;
+    CKBVM_MULADD(dh, dl, a0, a4);
+    CKBVM_MULADD(dh, dl, a1 * 2, a3);
+    CKBVM_MULADD(dh, dl, a2, a2);
+    /* [d t3 0 0 0] = [p8 0 0 0 p4 p3 0 0 0] */
+    CKBVM_MULADD(dh, dl, cl, R);
+    /* [d t4+(tx<<48) t3 0 0 0] = [p8 0 0 0 p4 p3 0 0 0] */
+    t4 = dl & M;
+    CKBVM_SHR52(dh, dl);
+    tx = (t4 >> 48);
+    t4 &= (M >> 4);
+
+    /* [d t4+(tx<<48) t3 0 0 c] = [p8 0 0 p5 p4 p3 0 0 p0] */
+    CKBVM_MUL(ch, cl, a0, a0);
+    CKBVM_MULADD(dh, dl, a1, a4);
+    CKBVM_MULADD(dh, dl, a2 * 2, a3);
+    /* [d 0 t4+(u0<<48) t3 0 0 c] = [p8 0 0 p5 p4 p3 0 0 p0] */
+    u0 = dl & M;
+    CKBVM_SHR52(dh, dl);
+    u0 = (u0 << 4) | tx;
+    /* [d 0 t4 t3 0 c r0] = [p8 0 0 p5 p4 p3 0 0 p0] */
+    CKBVM_MULADD(ch, cl, u0, R >> 4);
+    r[0] = cl & M;
+    CKBVM_SHR52(ch, cl);
+
+    /* [d 0 t4 t3 0 c r0] = [p8 0 p6 p5 p4 p3 0 p1 p0] */
+    a0 *= 2;
+    CKBVM_MULADD(ch, cl, a0, a1);
+    CKBVM_MULADD(dh, dl, a2, a4);
+    CKBVM_MULADD(dh, dl, a3, a3);
+    /* [d 0 0 t4 t3 c r1 r0] = [p8 0 p6 p5 p4 p3 0 p1 p0] */
+    CKBVM_MULADD(ch, cl, dl & M, R);
+    CKBVM_SHR52(dh, dl);
+    r[1] = cl & M;
+    CKBVM_SHR52(ch, cl);
+
+    /* [d 0 0 t4 t3 c r1 r0] = [p8 p7 p6 p5 p4 p3 p2 p1 p0] */
+    CKBVM_MULADD(ch, cl, a0, a2);
+    CKBVM_MULADD(ch, cl, a1, a1);
+    CKBVM_MULADD(dh, dl, a3, a4);
+    /* [d 0 0 0 t4 t3+c r2 r1 r0] = [p8 p7 p6 p5 p4 p3 p2 p1 p0] */
+    CKBVM_MULADD(ch, cl, dl & M, R);
+    CKBVM_SHR52(dh, dl);
+    r[2] = cl & M;
+    CKBVM_SHR52(ch, cl);
+
+    /* [t4+c r3 r2 r1 r0] = [p8 p7 p6 p5 p4 p3 p2 p1 p0], d < 2^62 */
+    CKBVM_MULADD(ch, cl, dl, R);
+    CKBVM_ADD(ch, cl, t3);
+    r[3] = cl & M;
+    CKBVM_SHR52(ch, cl);
+    /* [r4 r3 r2 r1 r0] = [p8 p7 p6 p5 p4 p3 p2 p1 p0], c < 2^48 */
+    r[4] = cl + t4;
+}
+
+#endif
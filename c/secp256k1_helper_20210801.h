@@ -15,6 +15,9 @@
  */
 #define HAVE_CONFIG_H 1
 #define USE_EXTERNAL_DEFAULT_CALLBACKS
+#ifdef CKB_SECP256K1_FIELD_CKBVM
+#include "secp256k1_ckbvm/field_5x52_ckbvm_impl.h"
+#endif
 #include <secp256k1.c>
 
 void secp256k1_default_illegal_callback_fn(const char* str, void* data) {
@@ -0,0 +1,46 @@
+#ifndef CKB_SECP256R1_HELPER_H_
+#define CKB_SECP256R1_HELPER_H_
+
+#include "ckb_syscalls.h"
+#include "secp256r1_data_info.h"
+#include "secp256r1/secp256r1_inc.h"
+
+_Static_assert(CKB_SECP256R1_DATA_WINDOW == SECP256R1_WINDOW_G,
+               "secp256r1 data is dumped with a different window");
+
+/*
+ * Loads the G table dumped by dump_secp256r1_data from cell deps. data should
+ * be at least CKB_SECP256R1_DATA_SIZE big and 8-byte aligned.
+ */
+int ckb_secp256r1_load_data(void* data) {
+    size_t index = 0;
+    while (index < SIZE_MAX) {
+        uint64_t len = 32;
+        uint8_t hash[32];
+
+        int ret = ckb_load_cell_by_field(hash, &len, 0, index,
+                                         CKB_SOURCE_CELL_DEP,
+                                         CKB_CELL_FIELD_DATA_HASH);
+        switch (ret) {
+            case CKB_ITEM_MISSING:
+                break;
+            case CKB_SUCCESS:
+                if (memcmp(ckb_secp256r1_data_hash, hash, 32) == 0) {
+                    len = CKB_SECP256R1_DATA_SIZE;
+                    ret = ckb_load_cell_data(data, &len, 0, index,
+                                             CKB_SOURCE_CELL_DEP);
+                    if (ret != CKB_SUCCESS || len != CKB_SECP256R1_DATA_SIZE) {
+                        return Secp256r1Err_LoadData;
+                    }
+                    return 0;
+                }
+                break;
+            default:
+                return Secp256r1Err_LoadData;
+        }
+        index++;
+    }
+    return Secp256r1Err_LoadData;
+}
+
+#endif
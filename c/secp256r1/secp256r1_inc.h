@@ -0,0 +1,551 @@
+// secp256r1 (NIST P-256) ECDSA verification used by AuthAlgorithmIdSecp256r1
+// and AuthAlgorithmIdWebAuthn.
+//
+// u1*G + u2*Q is computed in one interleaved wNAF loop, so the 256 doublings
+// are shared by both multiplications. Odd multiples of G (window
+// SECP256R1_WINDOW_G) are not computed at runtime: they are dumped by
+// c/dump_secp256r1_data.c in affine Montgomery form and loaded from a cell
+// dep, the same way ckb_secp256k1_custom_verify_only_initialize loads the
+// secp256k1 tables. Only 8 odd multiples of the public key are computed per
+// verification.
+//
+// Field and scalar arithmetic are plain 4x64-bit Montgomery multiplications,
+// all on the stack. No field inversion is needed at the end: x(R) == r is
+// checked as X == r * Z^2 in Jacobian coordinates.
+//
+// This file only depends on <stdint.h> and <string.h> so the dump tool can be
+// built with the host compiler.
+
+#define SECP256R1_LIMBS 4
+#define SECP256R1_FIELD_SIZE 32
+#define SECP256R1_PUBKEY_SIZE 64
+#define SECP256R1_SIGNATURE_SIZE 64
+#define SECP256R1_DIGEST_SIZE 32
+
+// Window of the G table loaded from cell dep: 2^(w-2) affine points.
+#define SECP256R1_WINDOW_G 12
+// Window of the public key, computed for every verification.
+#define SECP256R1_WINDOW_A 5
+#define SECP256R1_TABLE_SIZE(w) (1 << ((w)-2))
+// A wNAF of a 256-bit scalar has at most 257 digits.
+#define SECP256R1_WNAF_BITS 257
+
+enum Secp256r1ErrorCodeType {
+    Secp256r1Success = 0,
+    Secp256r1Err_InvalidPubkey = 250,
+    Secp256r1Err_InvalidSignature,
+    Secp256r1Err_Verify,
+    Secp256r1Err_LoadData,
+    Secp256r1Err_WebAuthn,
+};
+
+// Affine point, both coordinates in Montgomery form. This is the layout of
+// the table in cell dep.
+typedef struct Secp256r1Affine {
+    uint64_t x[SECP256R1_LIMBS];
+    uint64_t y[SECP256R1_LIMBS];
+} Secp256r1Affine;
+
+// Jacobian point in Montgomery form, Z == 0 is the point at infinity.
+typedef struct Secp256r1Jacobian {
+    uint64_t x[SECP256R1_LIMBS];
+    uint64_t y[SECP256R1_LIMBS];
+    uint64_t z[SECP256R1_LIMBS];
+} Secp256r1Jacobian;
+
+// All constants below are little endian limbs. Montgomery form is x * 2^256.
+static const uint64_t SECP256R1_P[SECP256R1_LIMBS] = {
+    0xffffffffffffffff, 0x00000000ffffffff, 0x0000000000000000,
+    0xffffffff00000001};
+// -P^-1 mod 2^64
+#define SECP256R1_P_MM 1
+static const uint64_t SECP256R1_P_RR[SECP256R1_LIMBS] = {
+    0x0000000000000003, 0xfffffffbffffffff, 0xfffffffffffffffe,
+    0x00000004fffffffd};
+static const uint64_t SECP256R1_P_ONE[SECP256R1_LIMBS] = {
+    0x0000000000000001, 0xffffffff00000000, 0xffffffffffffffff,
+    0x00000000fffffffe};
+static const uint64_t SECP256R1_B[SECP256R1_LIMBS] = {
+    0xd89cdf6229c4bddf, 0xacf005cd78843090, 0xe5a220abf7212ed6,
+    0xdc30061d04874834};
+static const uint64_t SECP256R1_GX[SECP256R1_LIMBS] = {
+    0x79e730d418a9143c, 0x75ba95fc5fedb601, 0x79fb732b77622510,
+    0x18905f76a53755c6};
+static const uint64_t SECP256R1_GY[SECP256R1_LIMBS] = {
+    0xddf25357ce95560a, 0x8b4ab8e4ba19e45c, 0xd2e88688dd21f325,
+    0x8571ff1825885d85};
+
+static const uint64_t SECP256R1_N[SECP256R1_LIMBS] = {
+    0xf3b9cac2fc632551, 0xbce6faada7179e84, 0xffffffffffffffff,
+    0xffffffff00000000};
+// -N^-1 mod 2^64
+#define SECP256R1_N_MM 0xccd1c8aaee00bc4f
+static const uint64_t SECP256R1_N_RR[SECP256R1_LIMBS] = {
+    0x83244c95be79eea2, 0x4699799c49bd6fa6, 0x2845b2392b6bec59,
+    0x66e12d94f3d95620};
+static const uint64_t SECP256R1_N_ONE[SECP256R1_LIMBS] = {
+    0x0c46353d039cdaaf, 0x4319055258e8617b, 0x0000000000000000,
+    0x00000000ffffffff};
+
+static void secp256r1_load_be(uint64_t r[SECP256R1_LIMBS], const uint8_t *in) {
+    for (int i = 0; i < SECP256R1_LIMBS; i++) {
+        uint64_t v = 0;
+        for (int j = 0; j < 8; j++) {
+            v = (v << 8) | in[(SECP256R1_LIMBS - 1 - i) * 8 + j];
+        }
+        r[i] = v;
+    }
+}
+
+static int secp256r1_is_zero(const uint64_t a[SECP256R1_LIMBS]) {
+    return (a[0] | a[1] | a[2] | a[3]) == 0;
+}
+
+static int secp256r1_equal(const uint64_t a[SECP256R1_LIMBS],
+                           const uint64_t b[SECP256R1_LIMBS]) {
+    return ((a[0] ^ b[0]) | (a[1] ^ b[1]) | (a[2] ^ b[2]) | (a[3] ^ b[3])) ==
+           0;
+}
+
+// a < b
+static int secp256r1_less(const uint64_t a[SECP256R1_LIMBS],
+                          const uint64_t b[SECP256R1_LIMBS]) {
+    for (int i = SECP256R1_LIMBS - 1; i >= 0; i--) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i];
+        }
+    }
+    return 0;
+}
+
+// r = a + b, returns carry
+static uint64_t secp256r1_add_limbs(uint64_t r[SECP256R1_LIMBS],
+                                    const uint64_t a[SECP256R1_LIMBS],
+                                    const uint64_t b[SECP256R1_LIMBS]) {
+    __uint128_t c = 0;
+    for (int i = 0; i < SECP256R1_LIMBS; i++) {
+        c += (__uint128_t)a[i] + b[i];
+        r[i] = (uint64_t)c;
+        c >>= 64;
+    }
+    return (uint64_t)c;
+}
+
+// r = a - b, returns borrow
+static uint64_t secp256r1_sub_limbs(uint64_t r[SECP256R1_LIMBS],
+                                    const uint64_t a[SECP256R1_LIMBS],
+                                    const uint64_t b[SECP256R1_LIMBS]) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < SECP256R1_LIMBS; i++) {
+        uint64_t t = a[i] - b[i];
+        uint64_t b1 = a[i] < b[i];
+        r[i] = t - borrow;
+        borrow = b1 | (t < borrow);
+    }
+    return borrow;
+}
+
+// r = a + b mod m, a and b < m
+static void secp256r1_mod_add(uint64_t r[SECP256R1_LIMBS],
+                              const uint64_t a[SECP256R1_LIMBS],
+                              const uint64_t b[SECP256R1_LIMBS],
+                              const uint64_t m[SECP256R1_LIMBS]) {
+    uint64_t t[SECP256R1_LIMBS], u[SECP256R1_LIMBS];
+    uint64_t carry = secp256r1_add_limbs(t, a, b);
+    uint64_t borrow = secp256r1_sub_limbs(u, t, m);
+    memcpy(r, (carry || !borrow) ? u : t, sizeof(t));
+}
+
+// r = a - b mod m, a and b < m
+static void secp256r1_mod_sub(uint64_t r[SECP256R1_LIMBS],
+                              const uint64_t a[SECP256R1_LIMBS],
+                              const uint64_t b[SECP256R1_LIMBS],
+                              const uint64_t m[SECP256R1_LIMBS]) {
+    if (secp256r1_sub_limbs(r, a, b)) {
+        secp256r1_add_limbs(r, r, m);
+    }
+}
+
+// r = a * b / 2^256 mod m (CIOS), a and b < m. r may alias a or b.
+static inline void secp256r1_mont_mul(uint64_t r[SECP256R1_LIMBS],
+                                      const uint64_t a[SECP256R1_LIMBS],
+                                      const uint64_t b[SECP256R1_LIMBS],
+                                      const uint64_t m[SECP256R1_LIMBS],
+                                      uint64_t mm) {
+    uint64_t t[SECP256R1_LIMBS + 2] = {0};
+    for (int i = 0; i < SECP256R1_LIMBS; i++) {
+        __uint128_t c = 0;
+        for (int j = 0; j < SECP256R1_LIMBS; j++) {
+            c += (__uint128_t)a[j] * b[i] + t[j];
+            t[j] = (uint64_t)c;
+            c >>= 64;
+        }
+        c += t[SECP256R1_LIMBS];
+        t[SECP256R1_LIMBS] = (uint64_t)c;
+        t[SECP256R1_LIMBS + 1] = (uint64_t)(c >> 64);
+
+        uint64_t q = t[0] * mm;
+        c = (__uint128_t)q * m[0] + t[0];
+        c >>= 64;
+        for (int j = 1; j < SECP256R1_LIMBS; j++) {
+            c += (__uint128_t)q * m[j] + t[j];
+            t[j - 1] = (uint64_t)c;
+            c >>= 64;
+        }
+        c += t[SECP256R1_LIMBS];
+        t[SECP256R1_LIMBS - 1] = (uint64_t)c;
+        t[SECP256R1_LIMBS] = t[SECP256R1_LIMBS + 1] + (uint64_t)(c >> 64);
+    }
+    uint64_t u[SECP256R1_LIMBS];
+    uint64_t borrow = secp256r1_sub_limbs(u, t, m);
+    memcpy(r, (t[SECP256R1_LIMBS] || !borrow) ? u : t, sizeof(u));
+}
+
+// r = a^e in Montgomery form, e is a plain 256-bit exponent. Fixed 4-bit
+// window: 256 squarings and at most 64 + 14 multiplications.
+static void secp256r1_mont_pow(uint64_t r[SECP256R1_LIMBS],
+                               const uint64_t a[SECP256R1_LIMBS],
+                               const uint64_t e[SECP256R1_LIMBS],
+                               const uint64_t m[SECP256R1_LIMBS], uint64_t mm,
+                               const uint64_t one[SECP256R1_LIMBS]) {
+    uint64_t pre[16][SECP256R1_LIMBS];
+    memcpy(pre[0], one, sizeof(pre[0]));
+    memcpy(pre[1], a, sizeof(pre[1]));
+    for (int i = 2; i < 16; i++) {
+        secp256r1_mont_mul(pre[i], pre[i - 1], a, m, mm);
+    }
+    uint64_t x[SECP256R1_LIMBS];
+    memcpy(x, one, sizeof(x));
+    for (int i = SECP256R1_LIMBS * 64 - 4; i >= 0; i -= 4) {
+        for (int j = 0; j < 4; j++) {
+            secp256r1_mont_mul(x, x, x, m, mm);
+        }
+        int nibble = (e[i / 64] >> (i % 64)) & 0xF;
+        if (nibble) {
+            secp256r1_mont_mul(x, x, pre[nibble], m, mm);
+        }
+    }
+    memcpy(r, x, sizeof(x));
+}
+
+static inline void secp256r1_fe_mul(uint64_t r[SECP256R1_LIMBS],
+                                    const uint64_t a[SECP256R1_LIMBS],
+                                    const uint64_t b[SECP256R1_LIMBS]) {
+    secp256r1_mont_mul(r, a, b, SECP256R1_P, SECP256R1_P_MM);
+}
+
+static inline void secp256r1_fe_sqr(uint64_t r[SECP256R1_LIMBS],
+                                    const uint64_t a[SECP256R1_LIMBS]) {
+    secp256r1_mont_mul(r, a, a, SECP256R1_P, SECP256R1_P_MM);
+}
+
+static inline void secp256r1_fe_add(uint64_t r[SECP256R1_LIMBS],
+                                    const uint64_t a[SECP256R1_LIMBS],
+                                    const uint64_t b[SECP256R1_LIMBS]) {
+    secp256r1_mod_add(r, a, b, SECP256R1_P);
+}
+
+static inline void secp256r1_fe_sub(uint64_t r[SECP256R1_LIMBS],
+                                    const uint64_t a[SECP256R1_LIMBS],
+                                    const uint64_t b[SECP256R1_LIMBS]) {
+    secp256r1_mod_sub(r, a, b, SECP256R1_P);
+}
+
+static void secp256r1_fe_neg(uint64_t r[SECP256R1_LIMBS],
+                             const uint64_t a[SECP256R1_LIMBS]) {
+    uint64_t zero[SECP256R1_LIMBS] = {0};
+    secp256r1_fe_sub(r, zero, a);
+}
+
+// Inversion, only used by the dump tool.
+static void secp256r1_fe_inv(uint64_t r[SECP256R1_LIMBS],
+                             const uint64_t a[SECP256R1_LIMBS]) {
+    uint64_t e[SECP256R1_LIMBS];
+    uint64_t two[SECP256R1_LIMBS] = {2, 0, 0, 0};
+    secp256r1_sub_limbs(e, SECP256R1_P, two);
+    secp256r1_mont_pow(r, a, e, SECP256R1_P, SECP256R1_P_MM, SECP256R1_P_ONE);
+}
+
+// Big endian bytes to Montgomery form, fails if the value is not below P.
+static int secp256r1_fe_from_bytes(uint64_t r[SECP256R1_LIMBS],
+                                   const uint8_t *in) {
+    secp256r1_load_be(r, in);
+    if (!secp256r1_less(r, SECP256R1_P)) {
+        return 0;
+    }
+    secp256r1_fe_mul(r, r, SECP256R1_P_RR);
+    return 1;
+}
+
+static void secp256r1_set_infinity(Secp256r1Jacobian *r) {
+    memset(r, 0, sizeof(*r));
+}
+
+static int secp256r1_is_infinity(const Secp256r1Jacobian *a) {
+    return secp256r1_is_zero(a->z);
+}
+
+// y^2 == x^3 - 3x + b
+static int secp256r1_is_on_curve(const uint64_t x[SECP256R1_LIMBS],
+                                 const uint64_t y[SECP256R1_LIMBS]) {
+    uint64_t lhs[SECP256R1_LIMBS], rhs[SECP256R1_LIMBS], t[SECP256R1_LIMBS];
+    secp256r1_fe_sqr(lhs, y);
+    secp256r1_fe_sqr(rhs, x);
+    secp256r1_fe_mul(rhs, rhs, x);
+    secp256r1_fe_add(t, x, x);
+    secp256r1_fe_add(t, t, x);
+    secp256r1_fe_sub(rhs, rhs, t);
+    secp256r1_fe_add(rhs, rhs, SECP256R1_B);
+    return secp256r1_equal(lhs, rhs);
+}
+
+// dbl-2001-b, a = -3. Also correct for the point at infinity.
+static void secp256r1_double(Secp256r1Jacobian *r, const Secp256r1Jacobian *a) {
+    uint64_t delta[SECP256R1_LIMBS], gamma[SECP256R1_LIMBS],
+        beta[SECP256R1_LIMBS], alpha[SECP256R1_LIMBS], t1[SECP256R1_LIMBS],
+        t2[SECP256R1_LIMBS];
+
+    secp256r1_fe_sqr(delta, a->z);
+    secp256r1_fe_sqr(gamma, a->y);
+    secp256r1_fe_mul(beta, a->x, gamma);
+
+    // alpha = 3 * (X - delta) * (X + delta)
+    secp256r1_fe_sub(t1, a->x, delta);
+    secp256r1_fe_add(t2, a->x, delta);
+    secp256r1_fe_mul(t1, t1, t2);
+    secp256r1_fe_add(alpha, t1, t1);
+    secp256r1_fe_add(alpha, alpha, t1);
+
+    // Z3 = (Y + Z)^2 - gamma - delta
+    secp256r1_fe_add(t1, a->y, a->z);
+    secp256r1_fe_sqr(t1, t1);
+    secp256r1_fe_sub(t1, t1, gamma);
+    secp256r1_fe_sub(r->z, t1, delta);
+
+    // X3 = alpha^2 - 8 * beta
+    secp256r1_fe_add(beta, beta, beta);
+    secp256r1_fe_add(beta, beta, beta);  // 4 * beta
+    secp256r1_fe_add(t2, beta, beta);    // 8 * beta
+    secp256r1_fe_sqr(t1, alpha);
+    secp256r1_fe_sub(r->x, t1, t2);
+
+    // Y3 = alpha * (4 * beta - X3) - 8 * gamma^2
+    secp256r1_fe_sub(t1, beta, r->x);
+    secp256r1_fe_mul(t1, alpha, t1);
+    secp256r1_fe_sqr(gamma, gamma);
+    secp256r1_fe_add(gamma, gamma, gamma);
+    secp256r1_fe_add(gamma, gamma, gamma);
+    secp256r1_fe_add(gamma, gamma, gamma);
+    secp256r1_fe_sub(r->y, t1, gamma);
+}
+
+// r = a + b, where b is given as (bx, by, bz) with bz == NULL meaning Z = 1
+// (mixed addition). b must not be the point at infinity.
+static void secp256r1_add_xyz(Secp256r1Jacobian *r, const Secp256r1Jacobian *a,
+                              const uint64_t bx[SECP256R1_LIMBS],
+                              const uint64_t by[SECP256R1_LIMBS],
+                              const uint64_t bz[SECP256R1_LIMBS]) {
+    if (secp256r1_is_infinity(a)) {
+        memcpy(r->x, bx, sizeof(r->x));
+        memcpy(r->y, by, sizeof(r->y));
+        memcpy(r->z, bz ? bz : SECP256R1_P_ONE, sizeof(r->z));
+        return;
+    }
+    uint64_t u1[SECP256R1_LIMBS], u2[SECP256R1_LIMBS], s1[SECP256R1_LIMBS],
+        s2[SECP256R1_LIMBS], h[SECP256R1_LIMBS], rr[SECP256R1_LIMBS],
+        t[SECP256R1_LIMBS];
+
+    // U2 = X2 * Z1^2, S2 = Y2 * Z1^3
+    secp256r1_fe_sqr(t, a->z);
+    secp256r1_fe_mul(u2, bx, t);
+    secp256r1_fe_mul(t, t, a->z);
+    secp256r1_fe_mul(s2, by, t);
+    if (bz) {
+        // U1 = X1 * Z2^2, S1 = Y1 * Z2^3
+        secp256r1_fe_sqr(t, bz);
+        secp256r1_fe_mul(u1, a->x, t);
+        secp256r1_fe_mul(t, t, bz);
+        secp256r1_fe_mul(s1, a->y, t);
+    } else {
+        memcpy(u1, a->x, sizeof(u1));
+        memcpy(s1, a->y, sizeof(s1));
+    }
+    secp256r1_fe_sub(h, u2, u1);
+    secp256r1_fe_sub(rr, s2, s1);
+    if (secp256r1_is_zero(h)) {
+        if (secp256r1_is_zero(rr)) {
+            secp256r1_double(r, a);
+        } else {
+            secp256r1_set_infinity(r);
+        }
+        return;
+    }
+
+    uint64_t hh[SECP256R1_LIMBS], hhh[SECP256R1_LIMBS], v[SECP256R1_LIMBS];
+    secp256r1_fe_sqr(hh, h);
+    secp256r1_fe_mul(hhh, h, hh);
+    secp256r1_fe_mul(v, u1, hh);
+
+    // Z3 = Z1 * Z2 * H
+    secp256r1_fe_mul(r->z, a->z, h);
+    if (bz) {
+        secp256r1_fe_mul(r->z, r->z, bz);
+    }
+    // X3 = R^2 - H^3 - 2 * V
+    secp256r1_fe_sqr(t, rr);
+    secp256r1_fe_sub(t, t, hhh);
+    secp256r1_fe_sub(t, t, v);
+    secp256r1_fe_sub(r->x, t, v);
+    // Y3 = R * (V - X3) - S1 * H^3
+    secp256r1_fe_sub(t, v, r->x);
+    secp256r1_fe_mul(t, rr, t);
+    secp256r1_fe_mul(s1, s1, hhh);
+    secp256r1_fe_sub(r->y, t, s1);
+}
+
+// Same wNAF representation as secp256k1_ecmult_wnaf: every non-zero digit is
+// odd, below 2^(w-1) in magnitude and followed by at least w-1 zeros. Returns
+// the number of digits used.
+static int secp256r1_wnaf(int wnaf[SECP256R1_WNAF_BITS],
+                          const uint64_t s[SECP256R1_LIMBS], int w) {
+    int bit = 0, carry = 0, last_set_bit = -1;
+    memset(wnaf, 0, sizeof(int) * SECP256R1_WNAF_BITS);
+    while (bit < SECP256R1_WNAF_BITS) {
+        int limb = bit / 64, shift = bit % 64;
+        uint64_t word = limb < SECP256R1_LIMBS ? s[limb] >> shift : 0;
+        if (shift + w > 64 && limb + 1 < SECP256R1_LIMBS) {
+            word |= s[limb + 1] << (64 - shift);
+        }
+        if ((int)(word & 1) == carry) {
+            bit++;
+            continue;
+        }
+        int value = (int)(word & ((1u << w) - 1)) + carry;
+        carry = (value >> (w - 1)) & 1;
+        value -= carry << w;
+        wnaf[bit] = value;
+        last_set_bit = bit;
+        bit += w;
+    }
+    return last_set_bit + 1;
+}
+
+// Fills table with G, 3G, 5G, ..., (2^(w-1) - 1)G in affine Montgomery form.
+// Used by c/dump_secp256r1_data.c, cost does not matter here.
+static void secp256r1_build_table(Secp256r1Affine *table, int w) {
+    Secp256r1Jacobian g, g2, p;
+    memcpy(g.x, SECP256R1_GX, sizeof(g.x));
+    memcpy(g.y, SECP256R1_GY, sizeof(g.y));
+    memcpy(g.z, SECP256R1_P_ONE, sizeof(g.z));
+    secp256r1_double(&g2, &g);
+    p = g;
+    for (int i = 0; i < SECP256R1_TABLE_SIZE(w); i++) {
+        uint64_t zi[SECP256R1_LIMBS], zi2[SECP256R1_LIMBS];
+        secp256r1_fe_inv(zi, p.z);
+        secp256r1_fe_sqr(zi2, zi);
+        secp256r1_fe_mul(table[i].x, p.x, zi2);
+        secp256r1_fe_mul(zi2, zi2, zi);
+        secp256r1_fe_mul(table[i].y, p.y, zi2);
+        secp256r1_add_xyz(&p, &p, g2.x, g2.y, g2.z);
+    }
+}
+
+// Verifies a (r, s) signature of a 32-byte digest, with the public key given
+// as x | y (64 bytes, big endian) and the signature as r | s (64 bytes, big
+// endian). table_g holds SECP256R1_TABLE_SIZE(SECP256R1_WINDOW_G) points.
+// Both low and high s are accepted.
+int secp256r1_verify(const Secp256r1Affine *table_g, const uint8_t *pubkey,
+                     const uint8_t *sig, const uint8_t *digest) {
+    uint64_t r[SECP256R1_LIMBS], s[SECP256R1_LIMBS], e[SECP256R1_LIMBS];
+    secp256r1_load_be(r, sig);
+    secp256r1_load_be(s, sig + SECP256R1_FIELD_SIZE);
+    if (secp256r1_is_zero(r) || !secp256r1_less(r, SECP256R1_N) ||
+        secp256r1_is_zero(s) || !secp256r1_less(s, SECP256R1_N)) {
+        return Secp256r1Err_InvalidSignature;
+    }
+
+    Secp256r1Jacobian pre_a[SECP256R1_TABLE_SIZE(SECP256R1_WINDOW_A)];
+    if (!secp256r1_fe_from_bytes(pre_a[0].x, pubkey) ||
+        !secp256r1_fe_from_bytes(pre_a[0].y, pubkey + SECP256R1_FIELD_SIZE) ||
+        !secp256r1_is_on_curve(pre_a[0].x, pre_a[0].y)) {
+        return Secp256r1Err_InvalidPubkey;
+    }
+    memcpy(pre_a[0].z, SECP256R1_P_ONE, sizeof(pre_a[0].z));
+
+    // w = s^-1, u1 = e * w, u2 = r * w. Multiplying a plain value with a
+    // Montgomery one gives a plain value.
+    uint64_t w[SECP256R1_LIMBS], n2[SECP256R1_LIMBS],
+        two[SECP256R1_LIMBS] = {2, 0, 0, 0};
+    secp256r1_sub_limbs(n2, SECP256R1_N, two);
+    secp256r1_mont_mul(w, s, SECP256R1_N_RR, SECP256R1_N, SECP256R1_N_MM);
+    secp256r1_mont_pow(w, w, n2, SECP256R1_N, SECP256R1_N_MM, SECP256R1_N_ONE);
+    secp256r1_load_be(e, digest);
+    if (!secp256r1_less(e, SECP256R1_N)) {
+        secp256r1_sub_limbs(e, e, SECP256R1_N);
+    }
+    uint64_t u1[SECP256R1_LIMBS], u2[SECP256R1_LIMBS];
+    secp256r1_mont_mul(u1, e, w, SECP256R1_N, SECP256R1_N_MM);
+    secp256r1_mont_mul(u2, r, w, SECP256R1_N, SECP256R1_N_MM);
+
+    // Q, 3Q, 5Q, ...
+    Secp256r1Jacobian q2;
+    secp256r1_double(&q2, &pre_a[0]);
+    for (int i = 1; i < SECP256R1_TABLE_SIZE(SECP256R1_WINDOW_A); i++) {
+        secp256r1_add_xyz(&pre_a[i], &pre_a[i - 1], q2.x, q2.y, q2.z);
+    }
+
+    int wnaf_g[SECP256R1_WNAF_BITS], wnaf_a[SECP256R1_WNAF_BITS];
+    int bits_g = secp256r1_wnaf(wnaf_g, u1, SECP256R1_WINDOW_G);
+    int bits_a = secp256r1_wnaf(wnaf_a, u2, SECP256R1_WINDOW_A);
+    int bits = bits_g > bits_a ? bits_g : bits_a;
+
+    Secp256r1Jacobian acc;
+    secp256r1_set_infinity(&acc);
+    uint64_t neg_y[SECP256R1_LIMBS];
+    for (int i = bits - 1; i >= 0; i--) {
+        if (!secp256r1_is_infinity(&acc)) {
+            secp256r1_double(&acc, &acc);
+        }
+        int d = wnaf_a[i];
+        if (d) {
+            const Secp256r1Jacobian *p = &pre_a[(d > 0 ? d : -d) / 2];
+            if (d > 0) {
+                secp256r1_add_xyz(&acc, &acc, p->x, p->y, p->z);
+            } else {
+                secp256r1_fe_neg(neg_y, p->y);
+                secp256r1_add_xyz(&acc, &acc, p->x, neg_y, p->z);
+            }
+        }
+        d = wnaf_g[i];
+        if (d) {
+            const Secp256r1Affine *p = &table_g[(d > 0 ? d : -d) / 2];
+            if (d > 0) {
+                secp256r1_add_xyz(&acc, &acc, p->x, p->y, NULL);
+            } else {
+                secp256r1_fe_neg(neg_y, p->y);
+                secp256r1_add_xyz(&acc, &acc, p->x, neg_y, NULL);
+            }
+        }
+    }
+    if (secp256r1_is_infinity(&acc)) {
+        return Secp256r1Err_Verify;
+    }
+
+    // x(acc) mod n == r, i.e. X == r' * Z^2 for r' in {r, r + n} below P.
+    uint64_t zz[SECP256R1_LIMBS], t[SECP256R1_LIMBS];
+    secp256r1_fe_sqr(zz, acc.z);
+    secp256r1_fe_mul(t, r, SECP256R1_P_RR);
+    secp256r1_fe_mul(t, t, zz);
+    if (secp256r1_equal(t, acc.x)) {
+        return Secp256r1Success;
+    }
+    if (secp256r1_add_limbs(r, r, SECP256R1_N) == 0 &&
+        secp256r1_less(r, SECP256R1_P)) {
+        secp256r1_fe_mul(t, r, SECP256R1_P_RR);
+        secp256r1_fe_mul(t, t, zz);
+        if (secp256r1_equal(t, acc.x)) {
+            return Secp256r1Success;
+        }
+    }
+    return Secp256r1Err_Verify;
+}
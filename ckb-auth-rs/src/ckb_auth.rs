@@ -6,7 +6,7 @@ use alloc::format;
 use ckb_std::{
     ckb_types::core::ScriptHashType,
     dynamic_loading_c_impl::{CKBDLContext, Library, Symbol},
-    high_level::spawn_cell,
+    high_level::{exec_cell, spawn_cell},
     syscalls::SysError,
 };
 use log::info;
@@ -54,6 +54,15 @@ pub enum AuthAlgorithmIdType {
     Schnorr = 7,
     Rsa = 8,
     Iso97962 = 9,
+    Litecoin = 10,
+    Cardano = 11,
+    Monero = 12,
+    Solana = 13,
+    Secp256r1 = 14,
+    WebAuthn = 15,
+    Bls12381 = 16,
+    HashPreimage = 17,
+    Composite = 18,
     OwnerLock = 0xFC,
 }
 
@@ -67,7 +76,7 @@ impl TryFrom<u8> for AuthAlgorithmIdType {
     type Error = CkbAuthError;
     fn try_from(value: u8) -> Result<Self, Self::Error> {
         if (value >= AuthAlgorithmIdType::Ckb.into()
-            && value <= AuthAlgorithmIdType::Iso97962.into())
+            && value <= AuthAlgorithmIdType::Composite.into())
             || value == AuthAlgorithmIdType::OwnerLock.into()
         {
             Ok(unsafe { transmute(value) })
@@ -83,7 +92,7 @@ pub struct CkbAuthType {
 }
 
 pub enum EntryCategoryType {
-    // Exec = 0,
+    Exec = 0,
     DynamicLinking = 1,
     Spawn = 2,
 }
@@ -92,7 +101,7 @@ impl TryFrom<u8> for EntryCategoryType {
     type Error = CkbAuthError;
     fn try_from(value: u8) -> Result<Self, Self::Error> {
         match value {
-            // 0 => Ok(Self::Exec),
+            0 => Ok(Self::Exec),
             1 => Ok(Self::DynamicLinking),
             2 => Ok(Self::Spawn),
             _ => Err(CkbAuthError::EncodeArgs),
@@ -113,7 +122,7 @@ pub fn ckb_auth(
     message: &[u8; 32],
 ) -> Result<(), CkbAuthError> {
     match entry.entry_category {
-        // EntryCategoryType::Exec => ckb_auth_exec(entry, id, signature, message),
+        EntryCategoryType::Exec => ckb_auth_exec(entry, id, signature, message),
         EntryCategoryType::DynamicLinking => ckb_auth_dl(entry, id, signature, message),
         EntryCategoryType::Spawn => ckb_auth_spawn(entry, id, signature, message),
     }
@@ -141,6 +150,39 @@ fn ckb_auth_spawn(
     Ok(())
 }
 
+/// Escape byte of the exec argv, see ckb_auth_exec_encode in c/ckb_auth.h.
+const EXEC_ESCAPE: u8 = 0xFE;
+
+fn exec_encode(data: &[u8], out: &mut Vec<u8>) {
+    for b in data {
+        match *b {
+            0 => out.extend_from_slice(&[EXEC_ESCAPE, 1]),
+            EXEC_ESCAPE => out.extend_from_slice(&[EXEC_ESCAPE, 2]),
+            _ => out.push(*b),
+        }
+    }
+}
+
+/// Replaces the current script with the auth binary: only returns on
+/// failure to exec, otherwise the exit code of the auth binary is the one of
+/// the script. Use it as the last check of a lock.
+fn ckb_auth_exec(
+    entry: &CkbEntryType,
+    id: &CkbAuthType,
+    signature: &[u8],
+    message: &[u8; 32],
+) -> Result<(), CkbAuthError> {
+    let mut arg = Vec::with_capacity((1 + 20 + 32 + signature.len()) * 2);
+    exec_encode(&[id.algorithm_id.clone() as u8], &mut arg);
+    exec_encode(&id.pubkey_hash, &mut arg);
+    exec_encode(message, &mut arg);
+    exec_encode(signature, &mut arg);
+    let arg = CString::new(arg)?;
+
+    exec_cell(&entry.code_hash, entry.hash_type, 0, 0, &[arg.as_c_str()])?;
+    Ok(())
+}
+
 type DLContext = CKBDLContext<[u8; 512 * 1024]>;
 type CkbAuthValidate = unsafe extern "C" fn(
     auth_algorithm_id: u8,
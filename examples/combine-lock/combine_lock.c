@@ -0,0 +1,358 @@
+// Combine lock: one lock group standing for several child auths.
+//
+// script args: root of a sparse merkle tree (32 bytes), whose keys are the
+// hashes of the allowed child script vectors.
+//
+// witness lock of the first input of the group: CombineLockWitness, see
+// combine_lock.mol
+//   scripts: the child scripts, each one being
+//     code_hash/hash_type: the auth binary
+//     args: <1 byte algorithm id> <20 bytes pubkey hash> <1 byte entry
+//     category>
+//   proof: compiled proof of hash(scripts) in the tree
+//   witness_base_index: the witness lock of witnesses[witness_base_index + i]
+//     is the signature of child i, after the witnesses of the inputs
+//
+// All children sign the same sighash_all message, computed once, and are
+// verified in this run. Dynamically linked children sharing an auth binary
+// load it only once. Exec children are rejected, exec never comes back to
+// verify the other children.
+
+#include "blake2b.h"
+#include "ckb_auth.h"
+#include "ckb_consts.h"
+#include "ckb_syscalls.h"
+#include "ckb_smt.h"
+#include "combine_lock_mol.h"
+
+#define BLAKE2B_BLOCK_SIZE 32
+#define MAX_WITNESS_SIZE 32768
+#define SCRIPT_SIZE 32768
+#define ONE_BATCH_SIZE 32768
+#define CHILD_ARGS_SIZE (1 + 20 + 1)
+// Distinct auth binaries of dynamically linked children.
+#define MAX_LOADED_AUTH 4
+
+enum CombineLockErrorCodeType {
+    ERROR_COMBINE_LOCK_ARGS = 80,
+    ERROR_COMBINE_LOCK_ENCODING,
+    ERROR_COMBINE_LOCK_WITNESS,
+    ERROR_COMBINE_LOCK_SMT,
+    ERROR_COMBINE_LOCK_CHILD_ARGS,
+    ERROR_COMBINE_LOCK_TOO_MANY_AUTH,
+};
+
+// Value of the leaves present in the tree, same as SMT_EXISTING of
+// tests/auth_spawn_rust.
+static const uint8_t SMT_VALUE_EXISTING[32] = {1};
+
+typedef struct LoadedAuth {
+    uint8_t code_hash[32];
+    uint8_t hash_type;
+    ckb_auth_validate_t validate;
+} LoadedAuth;
+
+static LoadedAuth g_loaded_auth[MAX_LOADED_AUTH];
+static size_t g_loaded_auth_count = 0;
+// Used part of g_code_buff of ckb_auth.h, binaries are loaded one after the
+// other instead of over each other.
+static size_t g_code_buff_used = 0;
+
+// Loads the witness at index of source, which must fit in buf, and returns
+// the raw bytes of its lock.
+static int load_witness_lock(uint8_t *buf, size_t index, size_t source,
+                             mol_seg_t *lock) {
+    uint64_t len = MAX_WITNESS_SIZE;
+    int err = ckb_load_witness(buf, &len, 0, index, source);
+    if (err != CKB_SUCCESS) {
+        return ERROR_COMBINE_LOCK_WITNESS;
+    }
+    if (len > MAX_WITNESS_SIZE) {
+        return ERROR_COMBINE_LOCK_WITNESS;
+    }
+    mol_seg_t witness_seg = {buf, (mol_num_t)len};
+    if (MolReader_WitnessArgs_verify(&witness_seg, false) != MOL_OK) {
+        return ERROR_COMBINE_LOCK_ENCODING;
+    }
+    mol_seg_t lock_seg = MolReader_WitnessArgs_get_lock(&witness_seg);
+    if (MolReader_BytesOpt_is_none(&lock_seg)) {
+        return ERROR_COMBINE_LOCK_WITNESS;
+    }
+    *lock = MolReader_Bytes_raw_bytes(&lock_seg);
+    return 0;
+}
+
+static int load_and_hash_witness(blake2b_state *ctx, size_t start,
+                                 size_t index, size_t source,
+                                 bool hash_length) {
+    uint8_t temp[ONE_BATCH_SIZE];
+    uint64_t len = ONE_BATCH_SIZE;
+    int ret = ckb_load_witness(temp, &len, start, index, source);
+    if (ret != CKB_SUCCESS) {
+        return ret;
+    }
+    if (hash_length) {
+        blake2b_update(ctx, (char *)&len, sizeof(uint64_t));
+    }
+    uint64_t offset = (len > ONE_BATCH_SIZE) ? ONE_BATCH_SIZE : len;
+    blake2b_update(ctx, temp, offset);
+    while (offset < len) {
+        uint64_t current_len = ONE_BATCH_SIZE;
+        ret = ckb_load_witness(temp, &current_len, start + offset, index,
+                               source);
+        if (ret != CKB_SUCCESS) {
+            return ret;
+        }
+        uint64_t current_read =
+            (current_len > ONE_BATCH_SIZE) ? ONE_BATCH_SIZE : current_len;
+        blake2b_update(ctx, temp, current_read);
+        offset += current_read;
+    }
+    return CKB_SUCCESS;
+}
+
+// Same as the sighash_all of auth_demo.c, except that the witnesses from
+// skip_begin to skip_end are not digested: they hold the signatures of the
+// children, which can't sign themselves. They come after the witnesses of
+// the inputs.
+static int generate_sighash_all(uint8_t *msg, size_t skip_begin,
+                                size_t skip_end) {
+    int ret;
+    uint64_t len = 0;
+    unsigned char temp[MAX_WITNESS_SIZE];
+    uint64_t read_len = MAX_WITNESS_SIZE;
+    uint64_t witness_len = MAX_WITNESS_SIZE;
+
+    /* Load witness of first input */
+    ret = ckb_load_witness(temp, &read_len, 0, 0, CKB_SOURCE_GROUP_INPUT);
+    if (ret != CKB_SUCCESS) {
+        return ERROR_COMBINE_LOCK_WITNESS;
+    }
+    witness_len = read_len;
+    if (read_len > MAX_WITNESS_SIZE) {
+        read_len = MAX_WITNESS_SIZE;
+    }
+
+    /* Clear the lock field to zero, then digest the first witness */
+    if (read_len < 20) {
+        return ERROR_COMBINE_LOCK_ENCODING;
+    }
+    uint32_t lock_length = *((uint32_t *)(&temp[16]));
+    if (read_len < 20 + lock_length) {
+        return ERROR_COMBINE_LOCK_ENCODING;
+    }
+    memset(&temp[20], 0, lock_length);
+
+    /* Load tx hash */
+    unsigned char tx_hash[BLAKE2B_BLOCK_SIZE];
+    len = BLAKE2B_BLOCK_SIZE;
+    ret = ckb_load_tx_hash(tx_hash, &len, 0);
+    if (ret != CKB_SUCCESS) {
+        return ret;
+    }
+    if (len != BLAKE2B_BLOCK_SIZE) {
+        return ERROR_COMBINE_LOCK_ENCODING;
+    }
+
+    blake2b_state blake2b_ctx;
+    blake2b_init(&blake2b_ctx, BLAKE2B_BLOCK_SIZE);
+    blake2b_update(&blake2b_ctx, tx_hash, BLAKE2B_BLOCK_SIZE);
+    blake2b_update(&blake2b_ctx, (char *)&witness_len, sizeof(uint64_t));
+    blake2b_update(&blake2b_ctx, temp, read_len);
+
+    // remaining of first witness
+    if (read_len < witness_len) {
+        ret = load_and_hash_witness(&blake2b_ctx, read_len, 0,
+                                    CKB_SOURCE_GROUP_INPUT, false);
+        if (ret != CKB_SUCCESS) {
+            return ERROR_COMBINE_LOCK_WITNESS;
+        }
+    }
+
+    // Digest same group witnesses
+    size_t i = 1;
+    while (1) {
+        ret = load_and_hash_witness(&blake2b_ctx, 0, i, CKB_SOURCE_GROUP_INPUT,
+                                    true);
+        if (ret == CKB_INDEX_OUT_OF_BOUND) {
+            break;
+        }
+        if (ret != CKB_SUCCESS) {
+            return ERROR_COMBINE_LOCK_WITNESS;
+        }
+        i += 1;
+    }
+
+    // Digest witnesses that not covered by inputs, but the signatures
+    i = (size_t)ckb_calculate_inputs_len();
+    while (1) {
+        if (i >= skip_begin && i < skip_end) {
+            i += 1;
+            continue;
+        }
+        ret = load_and_hash_witness(&blake2b_ctx, 0, i, CKB_SOURCE_INPUT, true);
+        if (ret == CKB_INDEX_OUT_OF_BOUND) {
+            break;
+        }
+        if (ret != CKB_SUCCESS) {
+            return ERROR_COMBINE_LOCK_WITNESS;
+        }
+        i += 1;
+    }
+
+    blake2b_final(&blake2b_ctx, msg, BLAKE2B_BLOCK_SIZE);
+    return 0;
+}
+
+// Returns ckb_auth_validate of the auth binary of entry, loading it on first
+// use. ckb_auth() would load it again for every child.
+static int load_auth(const CkbEntryType *entry, ckb_auth_validate_t *out) {
+    for (size_t i = 0; i < g_loaded_auth_count; i++) {
+        LoadedAuth *loaded = &g_loaded_auth[i];
+        if (loaded->hash_type == entry->hash_type &&
+            memcmp(loaded->code_hash, entry->code_hash, 32) == 0) {
+            *out = loaded->validate;
+            return 0;
+        }
+    }
+    if (g_loaded_auth_count == MAX_LOADED_AUTH) {
+        return ERROR_COMBINE_LOCK_TOO_MANY_AUTH;
+    }
+
+    void *handle = NULL;
+    size_t consumed_size = 0;
+    int err = ckb_dlopen2(entry->code_hash, entry->hash_type,
+                          g_code_buff + g_code_buff_used,
+                          sizeof(g_code_buff) - g_code_buff_used, &handle,
+                          &consumed_size);
+    if (err != 0) return err;
+    ckb_auth_validate_t validate =
+        (ckb_auth_validate_t)ckb_dlsym(handle, "ckb_auth_validate");
+    if (validate == 0) {
+        return CKB_INVALID_DATA;
+    }
+    // the next binary must be page aligned too
+    g_code_buff_used +=
+        (consumed_size + RISCV_PGSIZE - 1) / RISCV_PGSIZE * RISCV_PGSIZE;
+
+    LoadedAuth *loaded = &g_loaded_auth[g_loaded_auth_count++];
+    memcpy(loaded->code_hash, entry->code_hash, 32);
+    loaded->hash_type = entry->hash_type;
+    loaded->validate = validate;
+    *out = validate;
+    return 0;
+}
+
+static int verify_child(mol_seg_t *child_seg, const uint8_t *signature,
+                        uint32_t signature_size, const uint8_t *message32) {
+    mol_seg_t args_seg = MolReader_ChildScript_get_args(child_seg);
+    mol_seg_t args_bytes_seg = MolReader_Bytes_raw_bytes(&args_seg);
+    if (args_bytes_seg.size != CHILD_ARGS_SIZE) {
+        return ERROR_COMBINE_LOCK_CHILD_ARGS;
+    }
+    mol_seg_t code_hash_seg = MolReader_ChildScript_get_code_hash(child_seg);
+    mol_seg_t hash_type_seg = MolReader_ChildScript_get_hash_type(child_seg);
+
+    CkbEntryType entry;
+    memcpy(entry.code_hash, code_hash_seg.ptr, 32);
+    entry.hash_type = *hash_type_seg.ptr;
+    entry.entry_category = args_bytes_seg.ptr[21];
+
+    CkbAuthType auth;
+    auth.algorithm_id = args_bytes_seg.ptr[0];
+    memcpy(auth.content, args_bytes_seg.ptr + 1, 20);
+
+    if (entry.entry_category == EntryCategoryDynamicLinking) {
+        ckb_auth_validate_t validate = NULL;
+        int err = load_auth(&entry, &validate);
+        if (err != 0) return err;
+        return validate(auth.algorithm_id, signature, signature_size,
+                        message32, 32, auth.content, 20);
+    } else if (entry.entry_category == EntryCategorySpawn) {
+        return ckb_auth(&entry, &auth, signature, signature_size, message32);
+    } else {
+        return ERROR_COMBINE_LOCK_CHILD_ARGS;
+    }
+}
+
+int main() {
+    int err = 0;
+    uint64_t len = 0;
+
+    unsigned char script[SCRIPT_SIZE];
+    len = SCRIPT_SIZE;
+    err = ckb_load_script(script, &len, 0);
+    if (err != CKB_SUCCESS) {
+        return ERROR_COMBINE_LOCK_ARGS;
+    }
+    if (len > SCRIPT_SIZE) {
+        return ERROR_COMBINE_LOCK_ARGS;
+    }
+    mol_seg_t script_seg = {script, (mol_num_t)len};
+    if (MolReader_Script_verify(&script_seg, false) != MOL_OK) {
+        return ERROR_COMBINE_LOCK_ARGS;
+    }
+    mol_seg_t args_seg = MolReader_Script_get_args(&script_seg);
+    mol_seg_t root_seg = MolReader_Bytes_raw_bytes(&args_seg);
+    if (root_seg.size != 32) {
+        return ERROR_COMBINE_LOCK_ARGS;
+    }
+
+    uint8_t witness[MAX_WITNESS_SIZE];
+    mol_seg_t lock_seg;
+    err = load_witness_lock(witness, 0, CKB_SOURCE_GROUP_INPUT, &lock_seg);
+    if (err != 0) return err;
+    if (MolReader_CombineLockWitness_verify(&lock_seg, false) != MOL_OK) {
+        return ERROR_COMBINE_LOCK_ENCODING;
+    }
+    mol_seg_t scripts_seg = MolReader_CombineLockWitness_get_scripts(&lock_seg);
+    mol_seg_t proof_seg = MolReader_CombineLockWitness_get_proof(&lock_seg);
+    mol_seg_t proof_bytes_seg = MolReader_Bytes_raw_bytes(&proof_seg);
+    mol_seg_t index_seg =
+        MolReader_CombineLockWitness_get_witness_base_index(&lock_seg);
+
+    // the key is the hash of the whole child script vector
+    uint8_t key[BLAKE2B_BLOCK_SIZE];
+    blake2b_state blake2b_ctx;
+    blake2b_init(&blake2b_ctx, BLAKE2B_BLOCK_SIZE);
+    blake2b_update(&blake2b_ctx, scripts_seg.ptr, scripts_seg.size);
+    blake2b_final(&blake2b_ctx, key, BLAKE2B_BLOCK_SIZE);
+
+    smt_pair_t entries[1];
+    smt_state_t states;
+    smt_state_init(&states, entries, 1);
+    smt_state_insert(&states, key, SMT_VALUE_EXISTING);
+    smt_state_normalize(&states);
+    if (smt_verify(root_seg.ptr, &states, proof_bytes_seg.ptr,
+                   proof_bytes_seg.size) != 0) {
+        return ERROR_COMBINE_LOCK_SMT;
+    }
+
+    // the signatures must not overlap the witnesses of the inputs, which are
+    // digested by sighash_all
+    size_t base_index =
+        (size_t)index_seg.ptr[0] | ((size_t)index_seg.ptr[1] << 8);
+    if (base_index < (size_t)ckb_calculate_inputs_len()) {
+        return ERROR_COMBINE_LOCK_WITNESS;
+    }
+    mol_num_t count = MolReader_ChildScriptVec_length(&scripts_seg);
+    uint8_t message[BLAKE2B_BLOCK_SIZE];
+    err = generate_sighash_all(message, base_index, base_index + count);
+    if (err != 0) return err;
+
+    uint8_t signature_witness[MAX_WITNESS_SIZE];
+    for (mol_num_t i = 0; i < count; i++) {
+        mol_seg_res_t child = MolReader_ChildScriptVec_get(&scripts_seg, i);
+        if (child.errno != MOL_OK) {
+            return ERROR_COMBINE_LOCK_ENCODING;
+        }
+        mol_seg_t signature_seg;
+        err = load_witness_lock(signature_witness, base_index + i,
+                                CKB_SOURCE_INPUT, &signature_seg);
+        if (err != 0) return err;
+        err = verify_child(&child.seg, signature_seg.ptr, signature_seg.size,
+                           message);
+        if (err != 0) return err;
+    }
+    return 0;
+}
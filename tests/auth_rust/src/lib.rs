@@ -1,5 +1,5 @@
 use ckb_chain_spec::consensus::ConsensusBuilder;
-use ckb_crypto::secp::{Generator, Privkey};
+use ckb_crypto::secp::Privkey;
 use ckb_error::Error;
 use ckb_script::{TransactionScriptsVerifier, TxVerifyEnv};
 use ckb_traits::{CellDataProvider, ExtensionProvider, HeaderProvider};
@@ -27,6 +27,7 @@ use sha3::{Digest, Keccak256};
 use std::{collections::HashMap, mem::size_of, process::Stdio, result, vec};
 
 use std::{
+    cell::RefCell,
     process::{Child, Command},
     sync::Arc,
 };
@@ -44,8 +45,12 @@ pub const SOLANA_MAXIMUM_WRAPPED_SIGNATURE_SIZE: usize =
 lazy_static! {
     pub static ref AUTH_DEMO: Bytes = Bytes::from(&include_bytes!("../../../build/auth_demo")[..]);
     pub static ref AUTH_DL: Bytes = Bytes::from(&include_bytes!("../../../build/auth")[..]);
+    pub static ref AUTH_SPAWN: Bytes =
+        Bytes::from(&include_bytes!("../../../build/auth-spawn")[..]);
     pub static ref SECP256K1_DATA_BIN: Bytes =
         Bytes::from(&include_bytes!("../../../build/secp256k1_data_20210801")[..]);
+    pub static ref SECP256R1_DATA_BIN: Bytes =
+        Bytes::from(&include_bytes!("../../../build/secp256r1_data")[..]);
     pub static ref ALWAYS_SUCCESS: Bytes =
         Bytes::from(&include_bytes!("../../../build/always_success")[..]);
 }
@@ -71,6 +76,48 @@ pub fn calculate_sha256(buf: &[u8]) -> [u8; 32] {
     c.finalize().into()
 }
 
+thread_local! {
+    static KEY_RNG: RefCell<Option<rand::rngs::SmallRng>> = RefCell::new(None);
+}
+
+// Derives the keys of the auths created afterwards on this thread from
+// `seed`, so that the same transactions can be generated again. `None` goes
+// back to random keys. RSA keys are generated by mbedtls and stay random.
+pub fn set_key_seed(seed: Option<u64>) {
+    KEY_RNG.with(|r| *r.borrow_mut() = seed.map(rand::SeedableRng::seed_from_u64));
+}
+
+// 32 bytes of key material
+pub fn key_bytes() -> [u8; 32] {
+    let mut buf = [0u8; 32];
+    KEY_RNG.with(|r| match r.borrow_mut().as_mut() {
+        Some(rng) => rng.fill(&mut buf),
+        None => thread_rng().fill(&mut buf),
+    });
+    buf
+}
+
+// a valid secp256k1 secret key
+fn secp256k1_key_bytes() -> [u8; 32] {
+    loop {
+        let buf = key_bytes();
+        if secp256k1::SecretKey::from_slice(&buf).is_ok() {
+            return buf;
+        }
+    }
+}
+
+pub fn random_privkey() -> Privkey {
+    Privkey::from_slice(&secp256k1_key_bytes())
+}
+
+fn random_secp256k1_keypair() -> (secp256k1::SecretKey, secp256k1::PublicKey) {
+    let generator: secp256k1::Secp256k1<secp256k1::All> = secp256k1::Secp256k1::new();
+    let privkey = secp256k1::SecretKey::from_slice(&secp256k1_key_bytes()).unwrap();
+    let pubkey = secp256k1::PublicKey::from_secret_key(&generator, &privkey);
+    (privkey, pubkey)
+}
+
 #[derive(Clone, Copy)]
 pub enum AlgorithmType {
     Ckb = 0,
@@ -87,6 +134,11 @@ pub enum AlgorithmType {
     Cardano = 11,
     Monero = 12,
     Solana = 13,
+    Secp256r1 = 14,
+    WebAuthn = 15,
+    Bls12381 = 16,
+    HashPreimage = 17,
+    Composite = 18,
     OwnerLock = 0xFC,
 }
 
@@ -359,8 +411,10 @@ fn append_cells_deps<R: Rng>(
 ) -> (Capacity, TransactionBuilder) {
     let sighash_all_out_point = append_cell_deps(dummy, rng, &AUTH_DEMO);
     let sighash_dl_out_point = append_cell_deps(dummy, rng, &AUTH_DL);
+    let sighash_spawn_out_point = append_cell_deps(dummy, rng, &AUTH_SPAWN);
     let always_success_out_point = append_cell_deps(dummy, rng, &ALWAYS_SUCCESS);
     let secp256k1_data_out_point = append_cell_deps(dummy, rng, &SECP256K1_DATA_BIN);
+    let secp256r1_data_out_point = append_cell_deps(dummy, rng, &SECP256R1_DATA_BIN);
 
     // setup default tx builder
     let dummy_capacity = Capacity::shannons(42);
@@ -377,6 +431,12 @@ fn append_cells_deps<R: Rng>(
                 .dep_type(DepType::Code.into())
                 .build(),
         )
+        .cell_dep(
+            CellDep::new_builder()
+                .out_point(sighash_spawn_out_point)
+                .dep_type(DepType::Code.into())
+                .build(),
+        )
         .cell_dep(
             CellDep::new_builder()
                 .out_point(always_success_out_point)
@@ -389,6 +449,12 @@ fn append_cells_deps<R: Rng>(
                 .dep_type(DepType::Code.into())
                 .build(),
         )
+        .cell_dep(
+            CellDep::new_builder()
+                .out_point(secp256r1_data_out_point)
+                .dep_type(DepType::Code.into())
+                .build(),
+        )
         .output(
             CellOutput::new_builder()
                 .capacity(dummy_capacity.pack())
@@ -486,7 +552,7 @@ struct EntryType {
 
 #[derive(Clone, Copy)]
 pub enum EntryCategoryType {
-    // Exec = 0,
+    Exec = 0,
     DynamicLinking = 1,
     Spawn = 2,
 }
@@ -508,6 +574,9 @@ pub struct TestConfig {
     pub incorrect_msg: bool,
     pub incorrect_sign: bool,
     pub incorrect_sign_size: TestConfigIncorrectSing,
+
+    // Spawn or exec build/auth (PIE, relocates itself) instead of build/auth-spawn
+    pub spawn_pie: bool,
 }
 
 impl TestConfig {
@@ -525,6 +594,7 @@ impl TestConfig {
             incorrect_msg: false,
             incorrect_sign: false,
             incorrect_sign_size: TestConfigIncorrectSing::None,
+            spawn_pie: false,
         }
     }
 }
@@ -565,7 +635,12 @@ pub fn do_gen_args(config: &TestConfig, pub_key_hash: Option<Vec<u8>>) -> Bytes
             .copy_from_slice(&incorrect_pubkey.as_slice()[0..20]);
     }
 
-    let sighash_all_cell_data_hash = CellOutput::calc_data_hash(&AUTH_DL);
+    let sighash_all_cell_data_hash = match config.entry_category_type {
+        EntryCategoryType::Spawn | EntryCategoryType::Exec if !config.spawn_pie => {
+            CellOutput::calc_data_hash(&AUTH_SPAWN)
+        }
+        _ => CellOutput::calc_data_hash(&AUTH_DL),
+    };
     entry_type
         .code_hash
         .copy_from_slice(sighash_all_cell_data_hash.as_slice());
@@ -731,7 +806,9 @@ pub fn auth_builder(t: AlgorithmType, official: bool) -> result::Result<Box<dyn
         AlgorithmType::RSA => {
             return Ok(RSAAuth::new());
         }
-        AlgorithmType::Iso9796_2 => {}
+        AlgorithmType::Iso9796_2 => {
+            return Ok(Iso97962Auth::new());
+        }
         AlgorithmType::Litecoin => {
             return Ok(LitecoinAuth::new_official(official));
         }
@@ -744,6 +821,21 @@ pub fn auth_builder(t: AlgorithmType, official: bool) -> result::Result<Box<dyn
         AlgorithmType::Solana => {
             return Ok(SolanaAuth::new());
         }
+        AlgorithmType::Secp256r1 => {
+            return Ok(Secp256r1Auth::new());
+        }
+        AlgorithmType::WebAuthn => {
+            return Ok(WebAuthnAuth::new());
+        }
+        AlgorithmType::Bls12381 => {
+            return Ok(Bls12381Auth::new());
+        }
+        AlgorithmType::HashPreimage => {
+            return Ok(HashPreimageAuth::new(HashPreimageType::Blake160));
+        }
+        AlgorithmType::Composite => {
+            return Ok(CompositeAuth::new());
+        }
         AlgorithmType::OwnerLock => {
             return Ok(OwnerLockAuth::new());
         }
@@ -759,7 +851,7 @@ pub struct CKbAuth {
 }
 impl CKbAuth {
     fn generator_key() -> Privkey {
-        Generator::random_privkey()
+        random_privkey()
     }
     fn new() -> Box<dyn Auth> {
         Box::new(CKbAuth {
@@ -795,9 +887,7 @@ pub struct EthereumAuth {
 }
 impl EthereumAuth {
     fn new() -> Box<dyn Auth> {
-        let generator: secp256k1::Secp256k1<secp256k1::All> = secp256k1::Secp256k1::new();
-        let mut rng = thread_rng();
-        let (privkey, pubkey) = generator.generate_keypair(&mut rng);
+        let (privkey, pubkey) = random_secp256k1_keypair();
         Box::new(EthereumAuth { privkey, pubkey })
     }
     pub fn get_eth_pub_key_hash(pubkey: &secp256k1::PublicKey) -> Vec<u8> {
@@ -849,9 +939,7 @@ pub struct EosAuth {
 }
 impl EosAuth {
     fn new() -> Box<dyn Auth> {
-        let generator: secp256k1::Secp256k1<secp256k1::All> = secp256k1::Secp256k1::new();
-        let mut rng = thread_rng();
-        let (privkey, pubkey) = generator.generate_keypair(&mut rng);
+        let (privkey, pubkey) = random_secp256k1_keypair();
         Box::new(EosAuth { privkey, pubkey })
     }
 }
@@ -878,9 +966,7 @@ pub struct TronAuth {
 }
 impl TronAuth {
     fn new() -> Box<dyn Auth> {
-        let generator: secp256k1::Secp256k1<secp256k1::All> = secp256k1::Secp256k1::new();
-        let mut rng = thread_rng();
-        let (privkey, pubkey) = generator.generate_keypair(&mut rng);
+        let (privkey, pubkey) = random_secp256k1_keypair();
         Box::new(TronAuth { privkey, pubkey })
     }
 }
@@ -911,7 +997,7 @@ pub struct BitcoinAuth {
 }
 impl BitcoinAuth {
     pub fn new() -> Box<BitcoinAuth> {
-        let privkey = Generator::random_privkey();
+        let privkey = random_privkey();
         Box::new(BitcoinAuth {
             privkey,
             compress: true,
@@ -990,7 +1076,7 @@ pub struct DogecoinAuth {
 }
 impl DogecoinAuth {
     pub fn new() -> Box<DogecoinAuth> {
-        let privkey = Generator::random_privkey();
+        let privkey = random_privkey();
         Box::new(DogecoinAuth {
             privkey,
             compress: true,
@@ -1034,7 +1120,7 @@ pub struct LitecoinAuth {
 }
 impl LitecoinAuth {
     pub fn new() -> Box<LitecoinAuth> {
-        let sk: [u8; 32] = Generator::random_secret_key().secret_bytes();
+        let sk: [u8; 32] = secp256k1_key_bytes();
         Box::new(LitecoinAuth {
             official: false,
             sk,
@@ -1275,17 +1361,13 @@ pub struct MoneroAuth {
 impl MoneroAuth {
     pub fn new() -> Box<MoneroAuth> {
         fn get_random_key_pair() -> monero::KeyPair {
-            let mut rng = thread_rng();
-            let mut seed = vec![0; 32];
             let spend_key = loop {
-                rng.fill(seed.as_mut_slice());
-                if let Ok(key) = monero::PrivateKey::from_slice(&seed) {
+                if let Ok(key) = monero::PrivateKey::from_slice(&key_bytes()) {
                     break key;
                 }
             };
             let view_key = loop {
-                rng.fill(seed.as_mut_slice());
-                if let Ok(key) = monero::PrivateKey::from_slice(&seed) {
+                if let Ok(key) = monero::PrivateKey::from_slice(&key_bytes()) {
                     break key;
                 }
             };
@@ -1564,7 +1646,7 @@ impl CkbMultisigAuth {
 
         let mut pubkey_hashs: Vec<Privkey> = Vec::new();
         for _i in 0..pubkeys_cnt {
-            let privkey = Generator::random_privkey();
+            let privkey = random_privkey();
             let hash = CKbAuth::get_ckb_pub_key_hash(&privkey);
             pubkey_hashs.push(privkey);
             pubkey_data.put(Bytes::from(hash));
@@ -1622,9 +1704,7 @@ pub struct SchnorrAuth {
 }
 impl SchnorrAuth {
     pub fn new() -> Box<dyn Auth> {
-        let generator: secp256k1::Secp256k1<secp256k1::All> = secp256k1::Secp256k1::new();
-        let mut rng = thread_rng();
-        let (privkey, pubkey) = generator.generate_keypair(&mut rng);
+        let (privkey, pubkey) = random_secp256k1_keypair();
         Box::new(SchnorrAuth { privkey, pubkey })
     }
 }
@@ -1658,14 +1738,27 @@ impl Auth for SchnorrAuth {
     }
 }
 
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum RSAPadding {
+    Pkcs1V15 = 0,
+    Pss = 1,
+}
+
 #[derive(Clone)]
-struct RSAAuth {
+pub struct RSAAuth {
     pub pri_key: Vec<u8>,
     pub pub_key: Vec<u8>,
+    pub bits: u32,
+    pub padding: RSAPadding,
 }
 impl RSAAuth {
     fn new() -> Box<dyn Auth> {
-        let bits = 1024;
+        Self::new_with(2048, RSAPadding::Pkcs1V15)
+    }
+    pub fn new_with(bits: u32, padding: RSAPadding) -> Box<dyn Auth> {
+        Box::new(Self::generate(bits, padding))
+    }
+    pub fn generate(bits: u32, padding: RSAPadding) -> RSAAuth {
         let exponent = 65537;
 
         use mbedtls::pk::Pk;
@@ -1693,23 +1786,41 @@ impl RSAAuth {
             r.to_vec()
         };
 
-        Box::new(RSAAuth { pri_key, pub_key })
+        RSAAuth {
+            pri_key,
+            pub_key,
+            bits,
+            padding,
+        }
+    }
+    fn key_size(&self) -> u8 {
+        match self.bits {
+            1024 => 1,
+            2048 => 2,
+            4096 => 3,
+            _ => panic!("unsupported rsa key size"),
+        }
     }
-    fn rsa_sign(msg: &H256, privkey: &[u8], pubkey: &[u8]) -> Bytes {
-        let mut sig = Vec::<u8>::new();
-        sig.push(1); // algorithm id
-        sig.push(1); // key size, 1024
-        sig.push(0); // padding, PKCS# 1.5
-        sig.push(6); // hash type SHA256
+    // algorithm id, key size, padding, hash type (SHA256), E and N
+    fn rsa_info_header(&self) -> Vec<u8> {
+        let mut info = Vec::<u8>::new();
+        info.push(1); // algorithm id
+        info.push(self.key_size());
+        info.push(self.padding as u8);
+        info.push(6); // hash type SHA256
 
-        let (e, n) = Self::get_e_n(pubkey);
-        sig.extend_from_slice(&e); // 4 bytes E
-        sig.extend_from_slice(&n); // N
-        sig.extend_from_slice(&Self::rsa_sign_msg(msg, privkey));
+        let (e, n) = Self::get_e_n(&self.pub_key, (self.bits / 8) as usize);
+        info.extend_from_slice(&e); // 4 bytes E
+        info.extend_from_slice(&n); // N
+        info
+    }
+    fn rsa_sign(&self, msg: &H256) -> Bytes {
+        let mut sig = self.rsa_info_header();
+        sig.extend_from_slice(&Self::rsa_sign_msg(msg, &self.pri_key, self.padding));
 
         Bytes::from(sig.clone())
     }
-    fn get_e_n(pub_key: &[u8]) -> (Vec<u8>, Vec<u8>) {
+    fn get_e_n(pub_key: &[u8], key_bytes: usize) -> (Vec<u8>, Vec<u8>) {
         use mbedtls::pk::Pk;
         let pub_key = Pk::from_public_key(pub_key).expect("");
         let mut e = pub_key
@@ -1724,23 +1835,24 @@ impl RSAAuth {
             .unwrap();
         n.reverse();
 
-        while e.len() < 4 {
-            e.push(0);
-        }
-        while n.len() < 128 {
+        e.resize(4, 0);
+        while n.len() < key_bytes {
             n.push(0);
         }
 
         (e, n)
     }
-    fn rsa_sign_msg(msg: &H256, privkey: &[u8]) -> Vec<u8> {
+    fn rsa_sign_msg(msg: &H256, privkey: &[u8], padding: RSAPadding) -> Vec<u8> {
         use mbedtls::hash::Type::Sha256;
         use mbedtls::pk::{Options, Pk, RsaPadding};
         use mbedtls::rng::ctr_drbg::CtrDrbg;
 
         let mut priv_key = Pk::from_private_key(privkey, None).expect("import rsa private key");
         priv_key.set_options(Options::Rsa {
-            padding: RsaPadding::Pkcs1V15,
+            padding: match padding {
+                RSAPadding::Pkcs1V15 => RsaPadding::Pkcs1V15,
+                RSAPadding::Pss => RsaPadding::Pkcs1V21 { mgf: Sha256 },
+            },
         });
         let mut rng = CtrDrbg::new(Arc::new(mbedtls::rng::OsEntropy::new()), None)
             .expect("generate ctr drbg");
@@ -1760,29 +1872,493 @@ impl RSAAuth {
 }
 impl Auth for RSAAuth {
     fn get_sign_size(&self) -> usize {
-        264
+        8 + (self.bits / 8) as usize * 2
     }
     fn get_pub_key_hash(&self) -> Vec<u8> {
-        let (e, n) = Self::get_e_n(&self.pub_key);
+        let hash = ckb_hash::blake2b_256(self.rsa_info_header().as_slice());
+
+        hash[0..20].to_vec()
+    }
+    fn get_algorithm_type(&self) -> u8 {
+        AlgorithmType::RSA as u8
+    }
+    fn sign(&self, msg: &H256) -> Bytes {
+        self.rsa_sign(msg)
+    }
+}
 
-        let mut sig = Vec::<u8>::new();
-        sig.push(1); // algorithm id
-        sig.push(1); // key size, 1024
-        sig.push(0); // padding, PKCS# 1.5
-        sig.push(6); // hash type SHA256
+// ISO/IEC 9796-2 scheme 1 with full message recovery, SHA256 and an explicit
+// trailer, the same format as BouncyCastle's ISO9796d2Signer.
+#[derive(Clone)]
+pub struct Iso97962Auth {
+    pub rsa: RSAAuth,
+}
+impl Iso97962Auth {
+    fn new() -> Box<dyn Auth> {
+        Self::new_with(2048)
+    }
+    pub fn new_with(bits: u32) -> Box<dyn Auth> {
+        Box::new(Iso97962Auth {
+            rsa: RSAAuth::generate(bits, RSAPadding::Pkcs1V15),
+        })
+    }
+    fn info_header(&self) -> Vec<u8> {
+        let mut info = self.rsa.rsa_info_header();
+        info[0] = 2; // algorithm id, ISO 9796-2
+        info[2] = 0; // padding, unused
+        info
+    }
+    fn iso97962_sign(&self, msg: &H256) -> Bytes {
+        use mbedtls::bignum::Mpi;
+        use mbedtls::pk::Pk;
 
-        sig.extend_from_slice(&e);
-        sig.extend_from_slice(&n);
+        let key_bytes = (self.rsa.bits / 8) as usize;
+        let hash = calculate_sha256(msg.as_bytes());
+        let trailer = [0x34u8, 0xCC];
+        let padding_len = key_bytes - 1 - msg.as_bytes().len() - hash.len() - trailer.len();
+
+        // header | 0xBB .. 0xBA | M | H(M) | trailer
+        let mut em = vec![0x4Bu8];
+        em.resize(padding_len, 0xBB);
+        em.push(0xBA);
+        em.extend_from_slice(msg.as_bytes());
+        em.extend_from_slice(&hash);
+        em.extend_from_slice(&trailer);
+        assert_eq!(em.len(), key_bytes);
+
+        let pk = Pk::from_private_key(&self.rsa.pri_key, None).expect("import rsa private key");
+        let n = pk.rsa_public_modulus().expect("rsa modulus");
+        let d = pk.rsa_private_exponent().expect("rsa private exponent");
+        let m = Mpi::from_binary(&em).expect("encoded message");
+        let mut s = m
+            .modpow(&d, &n)
+            .expect("rsa private operation")
+            .to_binary()
+            .unwrap();
+        while s.len() < key_bytes {
+            s.insert(0, 0);
+        }
 
-        let hash = ckb_hash::blake2b_256(sig.as_slice());
+        let mut sig = self.info_header();
+        sig.extend_from_slice(&s);
+        Bytes::from(sig)
+    }
+}
+impl Auth for Iso97962Auth {
+    fn get_sign_size(&self) -> usize {
+        self.rsa.get_sign_size()
+    }
+    fn get_pub_key_hash(&self) -> Vec<u8> {
+        let hash = ckb_hash::blake2b_256(self.info_header().as_slice());
 
         hash[0..20].to_vec()
     }
     fn get_algorithm_type(&self) -> u8 {
-        AlgorithmType::RSA as u8
+        AlgorithmType::Iso9796_2 as u8
+    }
+    fn sign(&self, msg: &H256) -> Bytes {
+        self.iso97962_sign(msg)
+    }
+}
+
+#[derive(Clone)]
+pub struct Secp256r1Auth {
+    pub key: p256::ecdsa::SigningKey,
+}
+impl Secp256r1Auth {
+    pub fn new() -> Box<dyn Auth> {
+        Box::new(Self::generate())
+    }
+    pub fn generate() -> Secp256r1Auth {
+        loop {
+            let buf = key_bytes();
+            if let Ok(key) = p256::ecdsa::SigningKey::from_bytes(&buf.into()) {
+                return Secp256r1Auth { key };
+            }
+        }
+    }
+    // x | y, without the 0x04 prefix
+    pub fn get_pub_key(&self) -> Vec<u8> {
+        let point = self.key.verifying_key().to_encoded_point(false);
+        point.as_bytes()[1..].to_vec()
+    }
+    // r | s over SHA256(data)
+    pub fn sign_data(&self, data: &[u8]) -> Vec<u8> {
+        use p256::ecdsa::signature::Signer;
+        let sig: p256::ecdsa::Signature = self.key.sign(data);
+        sig.to_bytes().to_vec()
+    }
+}
+impl Auth for Secp256r1Auth {
+    fn get_pub_key_hash(&self) -> Vec<u8> {
+        ckb_hash::blake2b_256(self.get_pub_key())[..20].to_vec()
+    }
+    fn get_algorithm_type(&self) -> u8 {
+        AlgorithmType::Secp256r1 as u8
+    }
+    fn get_sign_size(&self) -> usize {
+        64 + 64
     }
     fn sign(&self, msg: &H256) -> Bytes {
-        RSAAuth::rsa_sign(msg, &self.pri_key, &self.pub_key)
+        let mut ret = self.get_pub_key();
+        ret.extend_from_slice(&self.sign_data(msg.as_bytes()));
+        Bytes::from(ret)
+    }
+}
+
+// Same as what navigator.credentials.get() returns, with the DER signature
+// converted to r | s.
+#[derive(Clone)]
+pub struct WebAuthnAuth {
+    pub key: Secp256r1Auth,
+}
+impl WebAuthnAuth {
+    pub const AUTHENTICATOR_DATA_SIZE: usize = 37;
+
+    pub fn new() -> Box<dyn Auth> {
+        Box::new(WebAuthnAuth {
+            key: Secp256r1Auth::generate(),
+        })
+    }
+    pub fn authenticator_data() -> Vec<u8> {
+        let mut data = calculate_sha256(b"example.com").to_vec();
+        // flags: user present | user verified
+        data.push(0x05);
+        // signature counter
+        data.extend_from_slice(&1u32.to_be_bytes());
+        data
+    }
+    pub fn client_data_json(msg: &[u8]) -> Vec<u8> {
+        use base64::Engine;
+        let challenge = base64::engine::general_purpose::URL_SAFE_NO_PAD.encode(msg);
+        format!(
+            r#"{{"type":"webauthn.get","challenge":"{}","origin":"https://example.com","crossOrigin":false}}"#,
+            challenge
+        )
+        .into_bytes()
+    }
+    pub fn client_data_json_size() -> usize {
+        Self::client_data_json(&[0u8; 32]).len()
+    }
+}
+impl Auth for WebAuthnAuth {
+    fn get_pub_key_hash(&self) -> Vec<u8> {
+        self.key.get_pub_key_hash()
+    }
+    fn get_algorithm_type(&self) -> u8 {
+        AlgorithmType::WebAuthn as u8
+    }
+    fn get_sign_size(&self) -> usize {
+        64 + 64 + 2 + Self::AUTHENTICATOR_DATA_SIZE + 2 + Self::client_data_json_size()
+    }
+    fn sign(&self, msg: &H256) -> Bytes {
+        let auth_data = Self::authenticator_data();
+        let client_data = Self::client_data_json(msg.as_bytes());
+
+        let mut signed_data = auth_data.clone();
+        signed_data.extend_from_slice(&calculate_sha256(&client_data));
+
+        let mut ret = self.key.get_pub_key();
+        ret.extend_from_slice(&self.key.sign_data(&signed_data));
+        ret.extend_from_slice(&(auth_data.len() as u16).to_le_bytes());
+        ret.extend_from_slice(&auth_data);
+        ret.extend_from_slice(&(client_data.len() as u16).to_le_bytes());
+        ret.extend_from_slice(&client_data);
+        Bytes::from(ret)
+    }
+}
+
+// A committee of BLS signers. The lock only sees the aggregated pubkey, so
+// proof of possession of every member key is assumed to be checked when the
+// committee is set up.
+#[derive(Clone)]
+pub struct Bls12381Auth {
+    pub privkeys: Vec<blst::min_pk::SecretKey>,
+}
+impl Bls12381Auth {
+    pub const DST: &'static [u8] = b"BLS_SIG_BLS12381G2_XMD:SHA-256_SSWU_RO_POP_";
+
+    pub fn new() -> Box<dyn Auth> {
+        Self::new_with(3)
+    }
+    pub fn new_with(signers: usize) -> Box<dyn Auth> {
+        let privkeys = (0..signers)
+            .map(|_| blst::min_pk::SecretKey::key_gen(&key_bytes(), &[]).expect("bls key gen"))
+            .collect();
+        Box::new(Bls12381Auth { privkeys })
+    }
+    pub fn aggregated_pubkey(&self) -> [u8; 48] {
+        let pubkeys: Vec<blst::min_pk::PublicKey> =
+            self.privkeys.iter().map(|k| k.sk_to_pk()).collect();
+        let pubkeys: Vec<&blst::min_pk::PublicKey> = pubkeys.iter().collect();
+        blst::min_pk::AggregatePublicKey::aggregate(&pubkeys, false)
+            .expect("aggregate pubkeys")
+            .to_public_key()
+            .compress()
+    }
+}
+impl Auth for Bls12381Auth {
+    fn get_pub_key_hash(&self) -> Vec<u8> {
+        ckb_hash::blake2b_256(self.aggregated_pubkey())[..20].to_vec()
+    }
+    fn get_algorithm_type(&self) -> u8 {
+        AlgorithmType::Bls12381 as u8
+    }
+    fn get_sign_size(&self) -> usize {
+        48 + 96
+    }
+    fn sign(&self, msg: &H256) -> Bytes {
+        let sigs: Vec<blst::min_pk::Signature> = self
+            .privkeys
+            .iter()
+            .map(|k| k.sign(msg.as_bytes(), Self::DST, &[]))
+            .collect();
+        let sigs: Vec<&blst::min_pk::Signature> = sigs.iter().collect();
+        let sig = blst::min_pk::AggregateSignature::aggregate(&sigs, false)
+            .expect("aggregate signatures")
+            .to_signature();
+
+        let mut ret = self.aggregated_pubkey().to_vec();
+        ret.extend_from_slice(&sig.compress());
+        Bytes::from(ret)
+    }
+}
+
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum HashPreimageType {
+    Blake160 = 0,
+    Sha256 = 1,
+    Hash160 = 2,
+    Ripemd160 = 3,
+}
+
+#[derive(Clone)]
+pub struct HashPreimageAuth {
+    pub preimage: Vec<u8>,
+    pub hash_type: HashPreimageType,
+}
+impl HashPreimageAuth {
+    pub fn new(hash_type: HashPreimageType) -> Box<dyn Auth> {
+        let preimage = key_bytes().to_vec();
+        Box::new(HashPreimageAuth {
+            preimage,
+            hash_type,
+        })
+    }
+}
+impl Auth for HashPreimageAuth {
+    fn get_pub_key_hash(&self) -> Vec<u8> {
+        use bitcoin::hashes::{hash160, ripemd160, sha256, Hash};
+        match self.hash_type {
+            HashPreimageType::Blake160 => ckb_hash::blake2b_256(&self.preimage)[..20].to_vec(),
+            HashPreimageType::Sha256 => sha256::Hash::hash(&self.preimage)[..20].to_vec(),
+            HashPreimageType::Hash160 => hash160::Hash::hash(&self.preimage)[..].to_vec(),
+            HashPreimageType::Ripemd160 => ripemd160::Hash::hash(&self.preimage)[..].to_vec(),
+        }
+    }
+    fn get_algorithm_type(&self) -> u8 {
+        AlgorithmType::HashPreimage as u8
+    }
+    fn get_sign_size(&self) -> usize {
+        1 + self.preimage.len()
+    }
+    fn sign(&self, _msg: &H256) -> Bytes {
+        let mut ret = vec![self.hash_type as u8];
+        ret.extend_from_slice(&self.preimage);
+        Bytes::from(ret)
+    }
+}
+
+#[derive(Clone)]
+pub struct CompositeAuth {
+    pub threshold: u8,
+    pub entries: Vec<Box<dyn Auth>>,
+    // indexes of the signing entries, in the order they are put in the witness
+    pub signers: Vec<usize>,
+}
+impl CompositeAuth {
+    pub fn new() -> Box<dyn Auth> {
+        let entries: Vec<Box<dyn Auth>> = vec![
+            EthereumAuth::new(),
+            BitcoinAuth::new() as Box<dyn Auth>,
+            Secp256r1Auth::new(),
+        ];
+        Self::new_with(2, entries, vec![0, 2])
+    }
+    pub fn new_with(
+        threshold: u8,
+        entries: Vec<Box<dyn Auth>>,
+        signers: Vec<usize>,
+    ) -> Box<dyn Auth> {
+        Box::new(CompositeAuth {
+            threshold,
+            entries,
+            signers,
+        })
+    }
+    pub fn policy(&self) -> Vec<u8> {
+        let mut ret = vec![self.threshold, self.entries.len() as u8];
+        for entry in &self.entries {
+            ret.push(entry.get_algorithm_type());
+            ret.extend_from_slice(&entry.get_pub_key_hash());
+        }
+        ret
+    }
+}
+impl Auth for CompositeAuth {
+    fn get_pub_key_hash(&self) -> Vec<u8> {
+        ckb_hash::blake2b_256(self.policy())[..20].to_vec()
+    }
+    fn get_algorithm_type(&self) -> u8 {
+        AlgorithmType::Composite as u8
+    }
+    fn get_sign_size(&self) -> usize {
+        self.policy().len()
+            + self
+                .signers
+                .iter()
+                .map(|i| 3 + self.entries[*i].get_sign_size())
+                .sum::<usize>()
+    }
+    fn sign(&self, msg: &H256) -> Bytes {
+        let mut ret = self.policy();
+        for i in &self.signers {
+            let entry = &self.entries[*i];
+            let sig = entry.sign(&entry.convert_message(&msg.0));
+            ret.push(*i as u8);
+            ret.extend_from_slice(&(sig.len() as u16).to_le_bytes());
+            ret.extend_from_slice(&sig);
+        }
+        Bytes::from(ret)
+    }
+}
+
+// EIP-2098 compact signature: r | s with the recovery id in the top bit of s,
+// from a 65 bytes r | s | recovery id one.
+pub fn compact_signature(sig: &[u8]) -> Bytes {
+    assert_eq!(sig.len(), 65);
+    let mut ret = sig[0..64].to_vec();
+    ret[32] |= (sig[64] & 1) << 7;
+    Bytes::from(ret)
+}
+
+// Same for the bitcoin layout, header | r | s. Compact signatures don't
+// carry the compressed flag of the header, they are only valid for
+// compressed keys.
+pub fn compact_btc_signature(sig: &[u8]) -> Bytes {
+    assert_eq!(sig.len(), 65);
+    let mut ret = sig[1..65].to_vec();
+    ret[32] |= ((sig[0] - 27) & 1) << 7;
+    Bytes::from(ret)
+}
+
+// Signs with the wrapped secp256k1 based auth and converts its signatures,
+// `signature_count` of them, to EIP-2098 compact ones.
+#[derive(Clone)]
+pub struct CompactSignatureAuth {
+    pub inner: Box<dyn Auth>,
+    pub signature_count: usize,
+}
+impl CompactSignatureAuth {
+    pub fn new(inner: Box<dyn Auth>) -> Box<dyn Auth> {
+        Box::new(CompactSignatureAuth {
+            inner,
+            signature_count: 1,
+        })
+    }
+    pub fn new_multisig(inner: Box<CkbMultisigAuth>) -> Box<dyn Auth> {
+        let signature_count = inner.threshold as usize;
+        Box::new(CompactSignatureAuth {
+            inner,
+            signature_count,
+        })
+    }
+}
+impl Auth for CompactSignatureAuth {
+    fn get_pub_key_hash(&self) -> Vec<u8> {
+        self.inner.get_pub_key_hash()
+    }
+    fn get_algorithm_type(&self) -> u8 {
+        self.inner.get_algorithm_type()
+    }
+    fn convert_message(&self, message: &[u8; 32]) -> H256 {
+        self.inner.convert_message(message)
+    }
+    fn sign(&self, msg: &H256) -> Bytes {
+        let sig = self.inner.sign(msg);
+        let algorithm_type = self.get_algorithm_type();
+        if algorithm_type == AlgorithmType::Bitcoin as u8
+            || algorithm_type == AlgorithmType::Dogecoin as u8
+            || algorithm_type == AlgorithmType::Litecoin as u8
+        {
+            return compact_btc_signature(&sig);
+        }
+        // the multisig script comes before the signatures
+        let signatures_begin = sig.len() - 65 * self.signature_count;
+        let mut ret = sig[..signatures_begin].to_vec();
+        for chunk in sig[signatures_begin..].chunks(65) {
+            ret.extend_from_slice(&compact_signature(chunk));
+        }
+        Bytes::from(ret)
+    }
+    fn message(&self) -> Bytes {
+        self.inner.message()
+    }
+    fn get_sign_size(&self) -> usize {
+        self.inner.get_sign_size() - self.signature_count
+    }
+}
+
+// Signs with the wrapped single signature secp256k1 based auth and replaces
+// the recovery id (or the bitcoin header) by the compressed public key:
+// pubkey(33) | r(32) | s(32). auth.c verifies these instead of recovering.
+#[derive(Clone)]
+pub struct PubkeySignatureAuth {
+    pub inner: Box<dyn Auth>,
+}
+impl PubkeySignatureAuth {
+    pub fn new(inner: Box<dyn Auth>) -> Box<dyn Auth> {
+        Box::new(PubkeySignatureAuth { inner })
+    }
+}
+impl Auth for PubkeySignatureAuth {
+    fn get_pub_key_hash(&self) -> Vec<u8> {
+        self.inner.get_pub_key_hash()
+    }
+    fn get_algorithm_type(&self) -> u8 {
+        self.inner.get_algorithm_type()
+    }
+    fn convert_message(&self, message: &[u8; 32]) -> H256 {
+        self.inner.convert_message(message)
+    }
+    fn sign(&self, msg: &H256) -> Bytes {
+        let sig = self.inner.sign(msg);
+        assert_eq!(sig.len(), 65);
+        let algorithm_type = self.get_algorithm_type();
+        let (rs, recid) = if algorithm_type == AlgorithmType::Bitcoin as u8
+            || algorithm_type == AlgorithmType::Dogecoin as u8
+            || algorithm_type == AlgorithmType::Litecoin as u8
+        {
+            (&sig[1..65], (sig[0] - 27) & 3)
+        } else {
+            (&sig[0..64], sig[64])
+        };
+
+        let secp: secp256k1::Secp256k1<secp256k1::All> = secp256k1::Secp256k1::new();
+        let recid = secp256k1::ecdsa::RecoveryId::from_i32(recid as i32).unwrap();
+        let signature = secp256k1::ecdsa::RecoverableSignature::from_compact(rs, recid).unwrap();
+        let msg = secp256k1::Message::from_slice(msg.as_bytes()).unwrap();
+        let pubkey = secp.recover_ecdsa(&msg, &signature).unwrap();
+
+        let mut ret = pubkey.serialize().to_vec();
+        ret.extend_from_slice(rs);
+        Bytes::from(ret)
+    }
+    fn message(&self) -> Bytes {
+        self.inner.message()
+    }
+    fn get_sign_size(&self) -> usize {
+        self.inner.get_sign_size() + 32
     }
 }
 
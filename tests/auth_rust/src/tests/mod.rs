@@ -18,10 +18,11 @@ use hex_literal::hex;
 
 use crate::{
     assert_script_error, auth_builder, build_resolved_tx, debug_printer, gen_args, gen_tx,
-    gen_tx_scripts_verifier, gen_tx_with_grouped_args, sign_tx, AlgorithmType, Auth,
-    AuthErrorCodeType, BitcoinAuth, CKbAuth, CkbMultisigAuth, DogecoinAuth, DummyDataLoader,
-    EntryCategoryType, EosAuth, EthereumAuth, LitecoinAuth, SchnorrAuth, TestConfig, TronAuth,
-    MAX_CYCLES,
+    gen_tx_scripts_verifier, gen_tx_with_grouped_args, set_key_seed, sign_tx, AlgorithmType, Auth,
+    AuthErrorCodeType, BitcoinAuth, Bls12381Auth, CKbAuth, CkbMultisigAuth, CompactSignatureAuth,
+    CompositeAuth, DogecoinAuth, DummyDataLoader, EntryCategoryType, EosAuth, EthereumAuth,
+    HashPreimageAuth, HashPreimageType, Iso97962Auth, LitecoinAuth, PubkeySignatureAuth, RSAAuth,
+    RSAPadding, SchnorrAuth, Secp256r1Auth, TestConfig, TronAuth, WebAuthnAuth, MAX_CYCLES,
 };
 
 fn verify_unit(config: &TestConfig) -> Result<u64, ckb_error::Error> {
@@ -303,6 +304,521 @@ fn solana_verify() {
     unit_test_common(AlgorithmType::Solana);
 }
 
+#[test]
+fn rsa_verify() {
+    unit_test_common(AlgorithmType::RSA);
+}
+
+#[test]
+fn rsa_verify_key_sizes() {
+    for bits in [1024, 2048, 4096] {
+        for padding in [RSAPadding::Pkcs1V15, RSAPadding::Pss] {
+            let auth = RSAAuth::new_with(bits, padding);
+            for t in [EntryCategoryType::DynamicLinking, EntryCategoryType::Spawn] {
+                let config = TestConfig::new(&auth, t, 1);
+                assert_result_ok(verify_unit(&config), "rsa key sizes");
+            }
+        }
+    }
+}
+
+#[test]
+fn iso9796_2_verify() {
+    unit_test_common(AlgorithmType::Iso9796_2);
+}
+
+#[test]
+fn secp256r1_verify() {
+    unit_test_common(AlgorithmType::Secp256r1);
+}
+
+#[test]
+fn webauthn_verify() {
+    unit_test_common(AlgorithmType::WebAuthn);
+}
+
+#[test]
+fn webauthn_wrong_challenge() {
+    #[derive(Clone)]
+    struct WebAuthnWrongChallenge(WebAuthnAuth);
+    impl Auth for WebAuthnWrongChallenge {
+        fn get_pub_key_hash(&self) -> Vec<u8> {
+            self.0.get_pub_key_hash()
+        }
+        fn get_algorithm_type(&self) -> u8 {
+            AlgorithmType::WebAuthn as u8
+        }
+        fn get_sign_size(&self) -> usize {
+            self.0.get_sign_size()
+        }
+        fn sign(&self, msg: &H256) -> Bytes {
+            // a valid assertion, but over another challenge
+            let mut other = msg.as_bytes().to_vec();
+            other[0] ^= 1;
+            self.0.sign(&H256::from_slice(&other).unwrap())
+        }
+    }
+
+    let auth: Box<dyn Auth> = Box::new(WebAuthnWrongChallenge(WebAuthnAuth {
+        key: Secp256r1Auth::generate(),
+    }));
+    for t in [EntryCategoryType::DynamicLinking, EntryCategoryType::Spawn] {
+        let config = TestConfig::new(&auth, t, 1);
+        assert!(verify_unit(&config).is_err());
+    }
+}
+
+#[test]
+fn algorithm_cycles() {
+    // The one cycle report: every algorithm that doesn't need an external
+    // client to sign, plus the key sizes, signer counts and hash types that
+    // change its cost. Compare the output of different builds of
+    // build/auth, e.g. `make ISA=b`. Printed as a markdown table.
+    let mut auths: Vec<(String, Box<dyn Auth>)> = [
+        ("ckb", AlgorithmType::Ckb),
+        ("ethereum", AlgorithmType::Ethereum),
+        ("eos", AlgorithmType::Eos),
+        ("tron", AlgorithmType::Tron),
+        ("bitcoin", AlgorithmType::Bitcoin),
+        ("dogecoin", AlgorithmType::Dogecoin),
+        ("schnorr", AlgorithmType::SchnorrOrTaproot),
+        ("monero", AlgorithmType::Monero),
+        ("secp256r1", AlgorithmType::Secp256r1),
+        ("webauthn", AlgorithmType::WebAuthn),
+        ("composite 2 of 3", AlgorithmType::Composite),
+    ]
+    .into_iter()
+    .map(|(name, t)| (name.to_string(), auth_builder(t, false).unwrap()))
+    .collect();
+    for bits in [1024, 2048, 4096] {
+        auths.push((
+            format!("rsa-{}", bits),
+            RSAAuth::new_with(bits, RSAPadding::Pkcs1V15),
+        ));
+        auths.push((
+            format!("rsa-{} pss", bits),
+            RSAAuth::new_with(bits, RSAPadding::Pss),
+        ));
+        auths.push((format!("iso9796-2-{}", bits), Iso97962Auth::new_with(bits)));
+    }
+    for signers in [5u8, 15, 50] {
+        auths.push((
+            format!("bls12-381 {} signers", signers),
+            Bls12381Auth::new_with(signers as usize),
+        ));
+        auths.push((
+            format!("ckb multisig {} of {}", signers, signers),
+            CkbMultisigAuth::new(signers, signers, 0) as Box<dyn Auth>,
+        ));
+    }
+    for hash_type in [
+        HashPreimageType::Blake160,
+        HashPreimageType::Sha256,
+        HashPreimageType::Hash160,
+        HashPreimageType::Ripemd160,
+    ] {
+        auths.push((
+            format!("hash preimage {:?}", hash_type),
+            HashPreimageAuth::new(hash_type),
+        ));
+    }
+
+    println!("| auth | algorithm id | dynamic linking | spawn | exec | witness bytes |");
+    println!("|---|---|---|---|---|---|");
+    for (name, auth) in &auths {
+        let cycles: Vec<String> = [
+            EntryCategoryType::DynamicLinking,
+            EntryCategoryType::Spawn,
+            EntryCategoryType::Exec,
+        ]
+        .into_iter()
+        .map(|t| {
+            let config = TestConfig::new(auth, t, 1);
+            verify_unit(&config).expect("verify").to_string()
+        })
+        .collect();
+        println!(
+            "| {} | {} | {} | {} |",
+            name,
+            auth.get_algorithm_type(),
+            cycles.join(" | "),
+            auth.get_sign_size()
+        );
+    }
+}
+
+#[test]
+fn exec_verify() {
+    for algorithm_type in [
+        AlgorithmType::Ckb,
+        AlgorithmType::Ethereum,
+        AlgorithmType::RSA,
+        AlgorithmType::Secp256r1,
+        AlgorithmType::Bls12381,
+    ] {
+        unit_test_common_with_runtype(algorithm_type, EntryCategoryType::Exec, false);
+    }
+
+    // build/auth relocates itself when exec'ed too
+    let auth = auth_builder(AlgorithmType::Ckb, false).unwrap();
+    let mut config = TestConfig::new(&auth, EntryCategoryType::Exec, 1);
+    config.spawn_pie = true;
+    assert_result_ok(verify_unit(&config), "exec build/auth");
+}
+
+#[test]
+fn composite_verify() {
+    unit_test_common(AlgorithmType::Composite);
+}
+
+#[test]
+fn composite_mixed_threshold() {
+    let entries = || -> Vec<Box<dyn Auth>> {
+        vec![
+            auth_builder(AlgorithmType::Ckb, false).unwrap(),
+            auth_builder(AlgorithmType::SchnorrOrTaproot, false).unwrap(),
+            auth_builder(AlgorithmType::Secp256r1, false).unwrap(),
+            auth_builder(AlgorithmType::HashPreimage, false).unwrap(),
+        ]
+    };
+    // 3 of 4
+    for signers in [vec![0, 1, 2], vec![1, 2, 3], vec![0, 2, 3]] {
+        let auth = CompositeAuth::new_with(3, entries(), signers);
+        for t in [EntryCategoryType::DynamicLinking, EntryCategoryType::Spawn] {
+            let config = TestConfig::new(&auth, t, 1);
+            assert_result_ok(verify_unit(&config), "composite");
+        }
+    }
+}
+
+#[test]
+fn composite_threshold_not_met() {
+    let auth = CompositeAuth::new_with(
+        2,
+        vec![
+            auth_builder(AlgorithmType::Ethereum, false).unwrap(),
+            auth_builder(AlgorithmType::Bitcoin, false).unwrap(),
+        ],
+        vec![1],
+    );
+    let config = TestConfig::new(&auth, EntryCategoryType::DynamicLinking, 1);
+    assert_result_error(
+        verify_unit(&config),
+        "composite threshold",
+        &[AuthErrorCodeType::Mismatched as i32],
+    );
+}
+
+#[test]
+fn composite_trailing_signature() {
+    // a signature past the threshold would make the witness malleable
+    let auth = CompositeAuth::new_with(
+        1,
+        vec![
+            auth_builder(AlgorithmType::Ethereum, false).unwrap(),
+            auth_builder(AlgorithmType::Bitcoin, false).unwrap(),
+        ],
+        vec![0, 1],
+    );
+    let config = TestConfig::new(&auth, EntryCategoryType::DynamicLinking, 1);
+    assert_result_error(
+        verify_unit(&config),
+        "composite trailing signature",
+        &[AuthErrorCodeType::InvalidArg as i32],
+    );
+}
+
+#[test]
+fn composite_duplicated_signer() {
+    let auth = CompositeAuth::new_with(
+        2,
+        vec![
+            auth_builder(AlgorithmType::Ethereum, false).unwrap(),
+            auth_builder(AlgorithmType::Bitcoin, false).unwrap(),
+        ],
+        vec![0, 0],
+    );
+    let config = TestConfig::new(&auth, EntryCategoryType::DynamicLinking, 1);
+    assert_result_error(
+        verify_unit(&config),
+        "composite duplicated signer",
+        &[AuthErrorCodeType::InvalidArg as i32],
+    );
+}
+
+#[test]
+fn secp256k1_compact_signature() {
+    let mut auths: Vec<Box<dyn Auth>> = [
+        AlgorithmType::Ckb,
+        AlgorithmType::Ethereum,
+        AlgorithmType::Eos,
+        AlgorithmType::Tron,
+        AlgorithmType::Bitcoin,
+        AlgorithmType::Dogecoin,
+    ]
+    .into_iter()
+    .map(|t| CompactSignatureAuth::new(auth_builder(t, false).unwrap()))
+    .collect();
+    auths.push(CompactSignatureAuth::new_multisig(CkbMultisigAuth::new(
+        3, 2, 1,
+    )));
+    for auth in &auths {
+        for t in [EntryCategoryType::DynamicLinking, EntryCategoryType::Spawn] {
+            let config = TestConfig::new(auth, t, 1);
+            let cycles = verify_unit(&config).expect("verify compact signature");
+            println!(
+                "algorithm {} compact signature entry category {}: {} cycles",
+                auth.get_algorithm_type(),
+                t as u8,
+                cycles
+            );
+        }
+    }
+
+    // compact signatures can't tell an uncompressed bitcoin key
+    let auth = CompactSignatureAuth::new(Box::new(BitcoinAuth {
+        privkey: Generator::random_privkey(),
+        compress: false,
+    }));
+    let config = TestConfig::new(&auth, EntryCategoryType::DynamicLinking, 1);
+    assert_result_error(
+        verify_unit(&config),
+        "compact signature of uncompressed key",
+        &[AuthErrorCodeType::Mismatched as i32],
+    );
+}
+
+#[test]
+fn secp256k1_pubkey_signature_cycles() {
+    // Carrying the compressed pubkey saves recovery's field inversion and
+    // serialization, the key is checked by its hash before any curve math.
+    for algorithm_type in [
+        AlgorithmType::Ckb,
+        AlgorithmType::Ethereum,
+        AlgorithmType::Eos,
+        AlgorithmType::Tron,
+        AlgorithmType::Bitcoin,
+        AlgorithmType::Dogecoin,
+    ] {
+        let auth = auth_builder(algorithm_type, false).unwrap();
+        let config = TestConfig::new(&auth, EntryCategoryType::DynamicLinking, 1);
+        let recover_cycles = verify_unit(&config).expect("verify recoverable signature");
+
+        let auth = PubkeySignatureAuth::new(auth);
+        let mut config = TestConfig::new(&auth, EntryCategoryType::DynamicLinking, 1);
+        let verify_cycles = verify_unit(&config).expect("verify pubkey signature");
+        println!(
+            "algorithm {}: recover {} cycles, verify {} cycles, delta {:+}",
+            algorithm_type as u8,
+            recover_cycles,
+            verify_cycles,
+            verify_cycles as i64 - recover_cycles as i64
+        );
+        assert!(verify_cycles < recover_cycles);
+
+        config.incorrect_pubkey = true;
+        assert_result_error(
+            verify_unit(&config),
+            "pubkey signature of another key",
+            &[AuthErrorCodeType::Mismatched as i32],
+        );
+    }
+
+    // the carried key passes the hash check, the signature doesn't verify
+    let auth = PubkeySignatureAuth::new(auth_builder(AlgorithmType::Ckb, false).unwrap());
+    let mut config = TestConfig::new(&auth, EntryCategoryType::DynamicLinking, 1);
+    config.incorrect_msg = true;
+    assert_result_error(
+        verify_unit(&config),
+        "pubkey signature of another message",
+        &[AuthErrorCodeType::ErrorWrongState as i32],
+    );
+}
+
+#[test]
+fn same_key_cycles() {
+    // 10 signatures from one key against 10 keys, in one run. Monero signs
+    // with a random nonce, so the signatures differ and the result cache
+    // doesn't short-circuit them, only the per-key point cache is shared.
+    let key = auth_builder(AlgorithmType::Monero, false).unwrap();
+    let same_key: Vec<Box<dyn Auth>> = (0..10).map(|_| key.clone()).collect();
+    let distinct_keys: Vec<Box<dyn Auth>> = (0..10)
+        .map(|_| auth_builder(AlgorithmType::Monero, false).unwrap())
+        .collect();
+    let mut results = vec![];
+    for (name, entries) in [("same key", same_key), ("distinct keys", distinct_keys)] {
+        let auth = CompositeAuth::new_with(10, entries, (0..10).collect());
+        let config = TestConfig::new(&auth, EntryCategoryType::DynamicLinking, 1);
+        let cycles = verify_unit(&config).expect("verify");
+        println!("monero 10 of 10, {}: {} cycles", name, cycles);
+        results.push(cycles);
+    }
+    assert!(results[0] < results[1]);
+}
+
+#[test]
+fn pubkey_mismatch_rejection_cycles() {
+    // Validators carrying the pubkey in the witness compare its hash first, so
+    // rejecting a witness for another key has to fit in a fraction of a
+    // successful verification.
+    for algorithm_type in [
+        AlgorithmType::SchnorrOrTaproot,
+        AlgorithmType::Monero,
+        AlgorithmType::Solana,
+        AlgorithmType::Secp256r1,
+        AlgorithmType::Bls12381,
+    ] {
+        let auth = auth_builder(algorithm_type, false).unwrap();
+        let mut config = TestConfig::new(&auth, EntryCategoryType::DynamicLinking, 1);
+        let cycles = verify_unit(&config).expect("verify");
+
+        config.incorrect_pubkey = true;
+        let mut data_loader = DummyDataLoader::new();
+        let tx = gen_tx(&mut data_loader, &config);
+        let tx = sign_tx(tx, &config);
+        let verifier = gen_tx_scripts_verifier(tx, data_loader);
+        let mismatched = |max_cycles: u64| {
+            verifier.verify(max_cycles).map_or_else(
+                |e| {
+                    e.to_string().contains(
+                        format!("error code {}", AuthErrorCodeType::Mismatched as i32).as_str(),
+                    )
+                },
+                |_| panic!("mismatched pubkey verified"),
+            )
+        };
+        assert!(mismatched(MAX_CYCLES), "mismatched pubkey");
+
+        // A failed run doesn't report its cycles: find the smallest budget
+        // that still ends with the script's own error instead of running
+        // out of cycles.
+        let (mut low, mut high) = (0, MAX_CYCLES);
+        while high - low > 1 {
+            let mid = low + (high - low) / 2;
+            if mismatched(mid) {
+                high = mid;
+            } else {
+                low = mid;
+            }
+        }
+        println!(
+            "algorithm {}: {} cycles, mismatched pubkey rejected in {} cycles",
+            auth.get_algorithm_type(),
+            cycles,
+            high
+        );
+        assert!(high < cycles / 2);
+    }
+}
+
+#[test]
+fn spawn_relocation_cycles() {
+    for algorithm_type in [AlgorithmType::Ckb, AlgorithmType::Secp256r1] {
+        let auth = auth_builder(algorithm_type, false).unwrap();
+        let mut config = TestConfig::new(&auth, EntryCategoryType::Spawn, 1);
+        let cycles = verify_unit(&config).expect("verify auth-spawn");
+        config.spawn_pie = true;
+        let pie_cycles = verify_unit(&config).expect("verify auth");
+        println!(
+            "algorithm {}: auth-spawn {} cycles, auth (PIE) {} cycles",
+            auth.get_algorithm_type(),
+            cycles,
+            pie_cycles
+        );
+        assert!(cycles < pie_cycles);
+    }
+}
+
+#[test]
+fn bls12381_verify() {
+    unit_test_common(AlgorithmType::Bls12381);
+}
+
+#[test]
+fn bls12381_committee_verify() {
+    for signers in [1, 50] {
+        let auth = Bls12381Auth::new_with(signers);
+        unit_test_common_with_auth(&auth, EntryCategoryType::DynamicLinking);
+        unit_test_common_with_auth(&auth, EntryCategoryType::Spawn);
+    }
+}
+
+#[test]
+fn hash_preimage_verify() {
+    for hash_type in [
+        HashPreimageType::Blake160,
+        HashPreimageType::Sha256,
+        HashPreimageType::Hash160,
+        HashPreimageType::Ripemd160,
+    ] {
+        let auth = HashPreimageAuth::new(hash_type);
+        unit_test_common_with_auth(&auth, EntryCategoryType::DynamicLinking);
+        unit_test_common_with_auth(&auth, EntryCategoryType::Spawn);
+    }
+}
+
+#[test]
+fn hash_preimage_wrong_type() {
+    // blake160 content, but the preimage claims to be a sha256 one
+    #[derive(Clone)]
+    struct WrongTypeAuth(HashPreimageAuth);
+    impl Auth for WrongTypeAuth {
+        fn get_pub_key_hash(&self) -> Vec<u8> {
+            self.0.get_pub_key_hash()
+        }
+        fn get_algorithm_type(&self) -> u8 {
+            AlgorithmType::HashPreimage as u8
+        }
+        fn get_sign_size(&self) -> usize {
+            self.0.get_sign_size()
+        }
+        fn sign(&self, _msg: &H256) -> Bytes {
+            let mut ret = vec![HashPreimageType::Sha256 as u8];
+            ret.extend_from_slice(&self.0.preimage);
+            Bytes::from(ret)
+        }
+    }
+    let auth: Box<dyn Auth> = Box::new(WrongTypeAuth(HashPreimageAuth {
+        preimage: vec![0x5a; 32],
+        hash_type: HashPreimageType::Blake160,
+    }));
+    for t in [EntryCategoryType::DynamicLinking, EntryCategoryType::Spawn] {
+        let config = TestConfig::new(&auth, t, 1);
+        assert_result_error(
+            verify_unit(&config),
+            "hash type",
+            &[AuthErrorCodeType::Mismatched as i32],
+        );
+    }
+}
+
+#[test]
+fn hash_preimage_cycles() {
+    // A preimage check is a single hash, it must cost less than a secp256k1
+    // signature of the same lock.
+    let ckb = auth_builder(AlgorithmType::Ckb, false).unwrap();
+    for t in [EntryCategoryType::DynamicLinking, EntryCategoryType::Spawn] {
+        let ckb_cycles = verify_unit(&TestConfig::new(&ckb, t, 1)).expect("verify ckb");
+        for hash_type in [
+            HashPreimageType::Blake160,
+            HashPreimageType::Sha256,
+            HashPreimageType::Hash160,
+            HashPreimageType::Ripemd160,
+        ] {
+            let auth = HashPreimageAuth::new(hash_type);
+            let cycles = verify_unit(&TestConfig::new(&auth, t, 1)).expect("verify preimage");
+            assert!(
+                cycles < ckb_cycles,
+                "hash type {} entry category {}: {} cycles, ckb {}",
+                hash_type as u8,
+                t as u8,
+                cycles,
+                ckb_cycles
+            );
+        }
+    }
+}
+
 #[test]
 fn convert_eth_error() {
     #[derive(Clone)]
@@ -721,3 +1237,27 @@ fn abnormal_algorithm_type() {
         );
     }
 }
+
+#[test]
+fn key_seed_reproducible() {
+    let pubkey_hashes = |seed: Option<u64>| -> Vec<Vec<u8>> {
+        set_key_seed(seed);
+        [
+            AlgorithmType::Ckb,
+            AlgorithmType::Ethereum,
+            AlgorithmType::Bitcoin,
+            AlgorithmType::Monero,
+            AlgorithmType::Secp256r1,
+            AlgorithmType::Bls12381,
+            AlgorithmType::HashPreimage,
+            AlgorithmType::Composite,
+        ]
+        .into_iter()
+        .map(|t| auth_builder(t, false).unwrap().get_pub_key_hash())
+        .collect()
+    };
+    let seeded = pubkey_hashes(Some(1));
+    assert_eq!(seeded, pubkey_hashes(Some(1)));
+    assert_ne!(seeded, pubkey_hashes(Some(2)));
+    assert_ne!(seeded, pubkey_hashes(None));
+}
@@ -0,0 +1,8 @@
+use auth_spawn_rust::combine_lock::{create_combine_lock_tx, CombineLockCase};
+
+pub fn main() -> Result<(), Box<dyn std::error::Error>> {
+    let tx = create_combine_lock_tx(CombineLockCase::OverlappingWitness)?;
+    let json = serde_json::to_string_pretty(&tx).unwrap();
+    println!("{}", json);
+    Ok(())
+}
@@ -0,0 +1,103 @@
+use crate::combine_lock_mol::{ChildScript, CombineLockWitness};
+use crate::hash::blake160;
+use crate::{create_simple_case, generate_sighash_all, read_tx_template, AUTH_DL};
+use ckb_crypto::secp::Privkey;
+use ckb_jsonrpc_types::JsonBytes;
+use ckb_mock_tx_types::ReprMockTransaction;
+use ckb_types::{
+    bytes::Bytes,
+    core::ScriptHashType,
+    packed::{CellOutput, Script, WitnessArgs, WitnessArgsBuilder},
+    prelude::*,
+    H256,
+};
+
+// Two children verified through dynamic linking of build/auth, so the
+// combine lock loads it only once.
+static G_PRIVKEY_BUFS: [[u8; 32]; 2] = [[0x01; 32], [0x02; 32]];
+
+pub enum CombineLockCase {
+    Success,
+    // A byte of the compiled proof is flipped.
+    BadProof,
+    // The second child is signed with the key of the first one.
+    WrongSignature,
+    // witness_base_index points at the witness of the input, the signatures
+    // are still where they are in the other cases.
+    OverlappingWitness,
+}
+
+pub fn create_combine_lock_tx(case: CombineLockCase) -> Result<ReprMockTransaction, anyhow::Error> {
+    let private_keys: Vec<Privkey> = G_PRIVKEY_BUFS
+        .iter()
+        .map(|buf| Privkey::from(H256::from(*buf)))
+        .collect();
+
+    let mut tx = read_tx_template("templates/combine-lock.json")?;
+
+    let auth_code_hash = CellOutput::calc_data_hash(&AUTH_DL);
+    let scripts: Vec<ChildScript> = private_keys
+        .iter()
+        .map(|key| {
+            let pubkey = key.pubkey().expect("pubkey").serialize();
+            let mut args = vec![0u8]; // AlgorithmIdCkb
+            args.extend_from_slice(&blake160(&pubkey));
+            args.push(1); // EntryCategoryDynamicLinking
+            Script::new_builder()
+                .code_hash(auth_code_hash.clone())
+                .hash_type(ScriptHashType::Data1.into())
+                .args(Bytes::from(args).pack())
+                .build()
+                .into()
+        })
+        .collect();
+    // the signatures follow the witness of the only input
+    let witness_base_index = match case {
+        CombineLockCase::OverlappingWitness => 0,
+        _ => 1,
+    };
+    let (root, mut witness_args) = create_simple_case(scripts, witness_base_index);
+    if let CombineLockCase::BadProof = case {
+        witness_args = flip_proof_byte(witness_args);
+    }
+    tx.mock_info.inputs[0].output.lock.args = JsonBytes::from_vec(root.as_slice().to_vec());
+
+    tx.tx.witnesses.clear();
+    tx.tx
+        .witnesses
+        .push(JsonBytes::from_bytes(witness_args.as_bytes()));
+    let message = generate_sighash_all(&tx, 0)?;
+
+    for key in &private_keys {
+        let key = match case {
+            CombineLockCase::WrongSignature => &private_keys[0],
+            _ => key,
+        };
+        let sig = key
+            .sign_recoverable(&H256::from(message))
+            .expect("sign")
+            .serialize();
+        tx.tx.witnesses.push(JsonBytes::from_bytes(
+            WitnessArgsBuilder::default()
+                .lock(Some(Bytes::from(sig)).pack())
+                .build()
+                .as_bytes(),
+        ));
+    }
+    Ok(tx)
+}
+
+fn flip_proof_byte(witness_args: WitnessArgs) -> WitnessArgs {
+    let lock = witness_args.lock().to_opt().unwrap().raw_data();
+    let witness = CombineLockWitness::new_unchecked(lock);
+    let mut proof = witness.proof().raw_data().to_vec();
+    *proof.last_mut().unwrap() ^= 1;
+    let witness = witness
+        .as_builder()
+        .proof(Bytes::from(proof).pack())
+        .build();
+    witness_args
+        .as_builder()
+        .lock(Some(witness.as_bytes()).pack())
+        .build()
+}
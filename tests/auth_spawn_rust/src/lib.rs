@@ -1,4 +1,5 @@
 pub mod auto_complete;
+pub mod combine_lock;
 #[allow(dead_code)]
 pub mod combine_lock_mol;
 pub mod hash;
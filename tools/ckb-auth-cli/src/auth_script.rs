@@ -1,7 +1,7 @@
 use anyhow::{anyhow, Error};
-use ckb_auth_rs::AlgorithmType;
+use ckb_auth_rs::{AlgorithmType, MAX_CYCLES, SECP256K1_DATA_BIN, SECP256R1_DATA_BIN};
 use ckb_vm::cost_model::estimate_cycles;
-use ckb_vm::registers::{A0, A7};
+use ckb_vm::registers::{A0, A1, A2, A3, A4, A5, A7};
 use ckb_vm::{Bytes, Memory, Register, SupportMachine, Syscalls};
 use hex::encode;
 use lazy_static::lazy_static;
@@ -44,13 +44,110 @@ impl<Mac: SupportMachine> Syscalls<Mac> for DebugSyscall {
     }
 }
 
+const SYS_LOAD_CELL_BY_FIELD: u64 = 2081;
+const SYS_LOAD_CELL_DATA: u64 = 2092;
+const SOURCE_CELL_DEP: u64 = 3;
+const CELL_FIELD_DATA_HASH: u64 = 1;
+const INDEX_OUT_OF_BOUND: u8 = 1;
+const ITEM_MISSING: u8 = 2;
+
+// Serves the secp256k1 and secp256r1 tables as cell deps 0 and 1, the only
+// cells build/auth reads when validating outside of a lock script. Anything
+// else is missing. Every VM running build/auth needs it, or the secp256k1
+// and secp256r1 based algorithms fail on the unknown syscall.
+pub struct CellDepSyscall {
+    cell_deps: Vec<(Vec<u8>, [u8; 32])>,
+}
+
+impl CellDepSyscall {
+    pub fn new() -> CellDepSyscall {
+        let cell_deps = [SECP256K1_DATA_BIN.to_vec(), SECP256R1_DATA_BIN.to_vec()]
+            .into_iter()
+            .map(|data| {
+                let hash = ckb_hash::blake2b_256(&data);
+                (data, hash)
+            })
+            .collect();
+        CellDepSyscall { cell_deps }
+    }
+}
+
+impl<Mac: SupportMachine> Syscalls<Mac> for CellDepSyscall {
+    fn initialize(&mut self, _machine: &mut Mac) -> Result<(), ckb_vm::error::Error> {
+        Ok(())
+    }
+
+    fn ecall(&mut self, machine: &mut Mac) -> Result<bool, ckb_vm::error::Error> {
+        let code = machine.registers()[A7].to_u64();
+        if code != SYS_LOAD_CELL_BY_FIELD && code != SYS_LOAD_CELL_DATA {
+            return Ok(false);
+        }
+        let index = machine.registers()[A3].to_u64() as usize;
+        let source = machine.registers()[A4].to_u64();
+        let cell = if source == SOURCE_CELL_DEP {
+            self.cell_deps.get(index)
+        } else {
+            None
+        };
+        let (data, hash) = match cell {
+            Some(c) => c,
+            None => {
+                machine.set_register(A0, Mac::REG::from_u8(INDEX_OUT_OF_BOUND));
+                return Ok(true);
+            }
+        };
+        let content: &[u8] = if code == SYS_LOAD_CELL_DATA {
+            data
+        } else if machine.registers()[A5].to_u64() == CELL_FIELD_DATA_HASH {
+            hash
+        } else {
+            machine.set_register(A0, Mac::REG::from_u8(ITEM_MISSING));
+            return Ok(true);
+        };
+
+        // partial loading, as in ckb-script
+        let addr = machine.registers()[A0].to_u64();
+        let size_addr = machine.registers()[A1].clone();
+        let offset = (machine.registers()[A2].to_u64() as usize).min(content.len());
+        let size = machine.memory_mut().load64(&size_addr)?.to_u64() as usize;
+        let full = &content[offset..];
+        let copied = size.min(full.len());
+        machine.memory_mut().store_bytes(addr, &full[..copied])?;
+        machine
+            .memory_mut()
+            .store64(&size_addr, &Mac::REG::from_u64(full.len() as u64))?;
+        machine.add_cycles_no_checking((copied as u64 + 3) / 4)?;
+        machine.set_register(A0, Mac::REG::from_u8(0));
+        Ok(true)
+    }
+}
+
 pub fn run_auth_exec(
     algorithm_id: AlgorithmType,
     pubkey_hash: &[u8],
     message: &[u8],
     sign: &[u8],
 ) -> Result<(), Error> {
-    let args_algorithm_id = format!("{:02X?}", algorithm_id as u8);
+    let exit = run_auth(algorithm_id as u8, pubkey_hash, message, sign)
+        .map_err(|e| anyhow!("run failed: {:?}", e))?;
+
+    if exit != 0 {
+        Err(anyhow!("verify failed, return code: {}", exit))
+    } else {
+        Ok(())
+    }
+}
+
+// Runs build/auth in ckb-vm within MAX_CYCLES and returns its exit code,
+// errors are only returned when the VM itself fails or the cycles run out
+// (ckb_vm::Error::CyclesExceeded).
+pub fn run_auth(
+    algorithm_id: u8,
+    pubkey_hash: &[u8],
+    message: &[u8],
+    sign: &[u8],
+) -> Result<i8, ckb_vm::Error> {
+    let args_algorithm_id = format!("{:02X?}", algorithm_id);
     let args_sign = encode(sign);
     let args_msg = encode(message);
     let args_pubkey_hash = encode(pubkey_hash);
@@ -58,29 +155,22 @@ pub fn run_auth_exec(
     let asm_core = ckb_vm::machine::asm::AsmCoreMachine::new(
         ckb_vm::ISA_IMC | ckb_vm::ISA_B | ckb_vm::ISA_MOP,
         ckb_vm::machine::VERSION1,
-        u64::MAX,
+        MAX_CYCLES,
     );
     let core = ckb_vm::DefaultMachineBuilder::new(asm_core)
         .instruction_cycle_func(Box::new(estimate_cycles))
         .syscall(Box::new(DebugSyscall {}))
+        .syscall(Box::new(CellDepSyscall::new()))
         .build();
     let mut machine = ckb_vm::machine::asm::AsmMachine::new(core);
-    machine
-        .load_program(
-            &AUTH_CODE,
-            &[
-                Bytes::copy_from_slice(args_algorithm_id.as_bytes()),
-                Bytes::copy_from_slice(args_sign.as_bytes()),
-                Bytes::copy_from_slice(args_msg.as_bytes()),
-                Bytes::copy_from_slice(args_pubkey_hash.as_bytes()),
-            ],
-        )
-        .expect("load auth_code failed");
-    let exit = machine.run().expect("run failed");
-
-    if exit != 0 {
-        Err(anyhow!("verify failed, return code: {}", exit))
-    } else {
-        Ok(())
-    }
+    machine.load_program(
+        &AUTH_CODE,
+        &[
+            Bytes::copy_from_slice(args_algorithm_id.as_bytes()),
+            Bytes::copy_from_slice(args_sign.as_bytes()),
+            Bytes::copy_from_slice(args_msg.as_bytes()),
+            Bytes::copy_from_slice(args_pubkey_hash.as_bytes()),
+        ],
+    )?;
+    machine.run()
 }
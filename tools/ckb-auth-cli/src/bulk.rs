@@ -0,0 +1,213 @@
+use crate::cycles::parse_entry_category;
+use crate::mock_tx::MockTransaction;
+use anyhow::{anyhow, Error};
+use ckb_auth_rs::{
+    auth_builder, gen_args, gen_tx_with_grouped_args, sign_tx_by_input_group, AlgorithmType, Auth,
+    CkbMultisigAuth, DummyDataLoader, EntryCategoryType, TestConfig,
+};
+use clap::{arg, value_parser, ArgAction, ArgMatches, Command};
+use rand::thread_rng;
+use std::fs;
+use std::path::Path;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::thread;
+use std::time::Instant;
+
+pub const DEFAULT_BULK_PATH: &str = "build/bulk";
+
+// Algorithms signed without an external client.
+const BULK_ALGORITHMS: [AlgorithmType; 16] = [
+    AlgorithmType::Ckb,
+    AlgorithmType::Ethereum,
+    AlgorithmType::Eos,
+    AlgorithmType::Tron,
+    AlgorithmType::Bitcoin,
+    AlgorithmType::Dogecoin,
+    AlgorithmType::CkbMultisig,
+    AlgorithmType::SchnorrOrTaproot,
+    AlgorithmType::RSA,
+    AlgorithmType::Iso9796_2,
+    AlgorithmType::Monero,
+    AlgorithmType::Secp256r1,
+    AlgorithmType::WebAuthn,
+    AlgorithmType::Bls12381,
+    AlgorithmType::HashPreimage,
+    AlgorithmType::Composite,
+];
+
+pub fn reg_bulk_generate_args(cmd: Command) -> Command {
+    cmd.arg(
+        arg!(-n --count <COUNT> "The number of transactions")
+            .value_parser(value_parser!(usize)),
+    )
+    .arg(
+        arg!(-a --algorithm <ALGORITHM_ID> "Algorithm ids to mix, all locally signable ones by default")
+            .value_parser(value_parser!(u8))
+            .action(ArgAction::Append)
+            .required(false),
+    )
+    .arg(
+        arg!(-g --groups <GROUPS> "Lock groups per transaction, each with the next algorithm")
+            .value_parser(value_parser!(usize))
+            .default_value("1"),
+    )
+    .arg(
+        arg!(-i --inputs <INPUTS> "Inputs per lock group")
+            .value_parser(value_parser!(usize))
+            .default_value("1"),
+    )
+    .arg(
+        arg!(-m --multisig <SHAPE> "Multisig shapes to use in turn, as <threshold>-of-<pubkeys>")
+            .action(ArgAction::Append)
+            .required(false),
+    )
+    .arg(arg!(-c --category <CATEGORY> "The entry category (dl, spawn or exec)").default_value("dl"))
+    .arg(arg!(-d --dir <DIR> "The directory to write to").required(false))
+    .arg(
+        arg!(-j --threads <THREADS> "Signing threads, the number of CPUs by default")
+            .value_parser(value_parser!(usize))
+            .required(false),
+    )
+}
+
+struct BulkConfig {
+    algorithms: Vec<AlgorithmType>,
+    // (threshold, pubkeys)
+    multisig_shapes: Vec<(u8, u8)>,
+    groups: usize,
+    inputs: usize,
+    category: EntryCategoryType,
+}
+
+fn parse_multisig_shape(s: &str) -> Result<(u8, u8), Error> {
+    let (threshold, pubkeys) = s
+        .split_once("-of-")
+        .ok_or_else(|| anyhow!("multisig shape {} is not <threshold>-of-<pubkeys>", s))?;
+    let threshold: u8 = threshold.parse()?;
+    let pubkeys: u8 = pubkeys.parse()?;
+    if threshold == 0 || threshold > pubkeys {
+        return Err(anyhow!("invalid multisig shape {}", s));
+    }
+    Ok((threshold, pubkeys))
+}
+
+fn entry_category_type(category: u8) -> EntryCategoryType {
+    match category {
+        1 => EntryCategoryType::DynamicLinking,
+        2 => EntryCategoryType::Spawn,
+        _ => EntryCategoryType::Exec,
+    }
+}
+
+pub fn bulk_generate(operate_mathches: &ArgMatches) -> Result<(), Error> {
+    let count = *operate_mathches
+        .get_one::<usize>("count")
+        .expect("get bulk count");
+    let algorithms = match operate_mathches.get_many::<u8>("algorithm") {
+        Some(ids) => ids
+            .map(|id| {
+                BULK_ALGORITHMS
+                    .into_iter()
+                    .find(|t| *t as u8 == *id)
+                    .ok_or_else(|| anyhow!("algorithm {} can't be signed here", id))
+            })
+            .collect::<Result<Vec<_>, Error>>()?,
+        None => BULK_ALGORITHMS.to_vec(),
+    };
+    let multisig_shapes = match operate_mathches.get_many::<String>("multisig") {
+        Some(shapes) => shapes
+            .map(|s| parse_multisig_shape(s))
+            .collect::<Result<Vec<_>, Error>>()?,
+        None => vec![(2, 3)],
+    };
+    let config = BulkConfig {
+        algorithms,
+        multisig_shapes,
+        groups: *operate_mathches.get_one::<usize>("groups").unwrap(),
+        inputs: *operate_mathches.get_one::<usize>("inputs").unwrap(),
+        category: entry_category_type(parse_entry_category(
+            operate_mathches.get_one::<String>("category").unwrap(),
+        )?),
+    };
+    if config.groups == 0 || config.inputs == 0 {
+        return Err(anyhow!("groups and inputs must be at least 1"));
+    }
+    let threads = match operate_mathches.get_one::<usize>("threads") {
+        Some(t) => *t,
+        None => thread::available_parallelism()?.get(),
+    };
+    let dir = operate_mathches
+        .get_one::<String>("dir")
+        .map(|s| s.as_str())
+        .unwrap_or(DEFAULT_BULK_PATH);
+    fs::create_dir_all(dir)?;
+
+    // Auths aren't Send, every thread builds its own. Transactions are
+    // numbered so that the mix doesn't depend on the number of threads.
+    let start = Instant::now();
+    let next = AtomicUsize::new(0);
+    thread::scope(|scope| -> Result<(), Error> {
+        let workers: Vec<_> = (0..threads.max(1))
+            .map(|_| {
+                scope.spawn(|| -> Result<(), Error> {
+                    loop {
+                        let index = next.fetch_add(1, Ordering::Relaxed);
+                        if index >= count {
+                            return Ok(());
+                        }
+                        let path = Path::new(dir).join(format!("tx-{:06}.json", index));
+                        generate_tx(&config, index)?.save(path.to_str().unwrap())?;
+                    }
+                })
+            })
+            .collect();
+        for worker in workers {
+            worker.join().expect("bulk generate thread")?;
+        }
+        Ok(())
+    })?;
+    println!(
+        "{} transactions written to {} in {:?}",
+        count,
+        dir,
+        start.elapsed()
+    );
+    Ok(())
+}
+
+fn build_auth(config: &BulkConfig, algorithm_type: AlgorithmType, n: usize) -> Box<dyn Auth> {
+    match algorithm_type {
+        AlgorithmType::CkbMultisig => {
+            let (threshold, pubkeys) = config.multisig_shapes[n % config.multisig_shapes.len()];
+            CkbMultisigAuth::new(pubkeys, threshold, 0) as Box<dyn Auth>
+        }
+        t => auth_builder(t, false).unwrap(),
+    }
+}
+
+// Lock group g of transaction index uses the (index * groups + g)-th
+// algorithm, so a run covers them evenly.
+fn generate_tx(config: &BulkConfig, index: usize) -> Result<MockTransaction, Error> {
+    let configs: Vec<TestConfig> = (0..config.groups)
+        .map(|g| {
+            let n = index * config.groups + g;
+            let algorithm_type = config.algorithms[n % config.algorithms.len()];
+            let auth = build_auth(config, algorithm_type, n / config.algorithms.len());
+            TestConfig::new(&auth, config.category, config.inputs as i32)
+        })
+        .collect();
+
+    let mut data_loader = DummyDataLoader::new();
+    let mut tx = gen_tx_with_grouped_args(
+        &mut data_loader,
+        configs
+            .iter()
+            .map(|c| (gen_args(c), config.inputs))
+            .collect(),
+        &mut thread_rng(),
+    );
+    for (g, c) in configs.iter().enumerate() {
+        tx = sign_tx_by_input_group(tx, c, g * config.inputs, config.inputs);
+    }
+    MockTransaction::from_tx(&tx, &data_loader)
+}
@@ -0,0 +1,124 @@
+use anyhow::{anyhow, Error};
+use ckb_auth_cli::estimate::{estimate_cycles, load_table, save_table, CyclesSample};
+use ckb_auth_rs::{
+    auth_builder, gen_tx, gen_tx_scripts_verifier, sign_tx, AlgorithmType, Auth, Bls12381Auth,
+    DummyDataLoader, EntryCategoryType, Iso97962Auth, RSAAuth, RSAPadding, TestConfig, MAX_CYCLES,
+};
+use clap::{arg, value_parser, ArgMatches, Command};
+
+pub const DEFAULT_TABLE_PATH: &str = "build/auth_cycles.json";
+
+pub fn reg_estimate_args(cmd: Command) -> Command {
+    cmd.arg(arg!(-a --algorithm <ALGORITHM_ID> "The algorithm id").value_parser(value_parser!(u8)))
+        .arg(arg!(-c --category <CATEGORY> "The entry category (dl, spawn or exec)"))
+        .arg(
+            arg!(-s --size <SIGNATURE_SIZE> "The signature size in bytes")
+                .value_parser(value_parser!(usize)),
+        )
+        .arg(arg!(-t --table <TABLE> "The calibration table").required(false))
+}
+
+pub fn reg_calibrate_args(cmd: Command) -> Command {
+    cmd.arg(arg!(-t --table <TABLE> "Where to write the calibration table").required(false))
+}
+
+pub fn estimate(operate_mathches: &ArgMatches) -> Result<(), Error> {
+    let algorithm_id = *operate_mathches
+        .get_one::<u8>("algorithm")
+        .expect("get estimate algorithm");
+    let entry_category = parse_entry_category(
+        operate_mathches
+            .get_one::<String>("category")
+            .expect("get estimate category"),
+    )?;
+    let signature_size = *operate_mathches
+        .get_one::<usize>("size")
+        .expect("get estimate size");
+    let table = load_table(get_table_path(operate_mathches))?;
+
+    let cycles = estimate_cycles(&table, algorithm_id, entry_category, signature_size)?;
+    println!("{}", cycles);
+    Ok(())
+}
+
+pub fn calibrate(operate_mathches: &ArgMatches) -> Result<(), Error> {
+    let path = get_table_path(operate_mathches);
+    let table = calibrate_table()?;
+    save_table(path, &table)?;
+    println!("{} samples written to {}", table.len(), path);
+    Ok(())
+}
+
+fn get_table_path(operate_mathches: &ArgMatches) -> &str {
+    operate_mathches
+        .get_one::<String>("table")
+        .map(|s| s.as_str())
+        .unwrap_or(DEFAULT_TABLE_PATH)
+}
+
+pub fn parse_entry_category(s: &str) -> Result<u8, Error> {
+    match s {
+        "dl" | "dynamic-linking" | "1" => Ok(EntryCategoryType::DynamicLinking as u8),
+        "spawn" | "2" => Ok(EntryCategoryType::Spawn as u8),
+        "exec" | "0" => Ok(EntryCategoryType::Exec as u8),
+        _ => Err(anyhow!("Unknown entry category {}", s)),
+    }
+}
+
+// Auths that can sign without an external client. Variable sized signatures
+// get more than one sample so estimate_cycles can interpolate.
+pub fn calibration_auths() -> Vec<Box<dyn Auth>> {
+    let mut auths: Vec<Box<dyn Auth>> = [
+        AlgorithmType::Ckb,
+        AlgorithmType::Ethereum,
+        AlgorithmType::Eos,
+        AlgorithmType::Tron,
+        AlgorithmType::Bitcoin,
+        AlgorithmType::Dogecoin,
+        AlgorithmType::SchnorrOrTaproot,
+        AlgorithmType::Monero,
+        AlgorithmType::Secp256r1,
+        AlgorithmType::WebAuthn,
+        AlgorithmType::HashPreimage,
+        AlgorithmType::Composite,
+    ]
+    .into_iter()
+    .map(|t| auth_builder(t, false).unwrap())
+    .collect();
+    for bits in [1024, 2048, 4096] {
+        auths.push(RSAAuth::new_with(bits, RSAPadding::Pkcs1V15));
+        auths.push(Iso97962Auth::new_with(bits));
+    }
+    for signers in [1, 3, 8] {
+        auths.push(Bls12381Auth::new_with(signers));
+    }
+    auths
+}
+
+pub fn calibrate_table() -> Result<Vec<CyclesSample>, Error> {
+    let mut table = Vec::new();
+    for auth in calibration_auths() {
+        let signature_size = auth.sign(&auth.convert_message(&[0u8; 32])).len();
+        for t in [
+            EntryCategoryType::DynamicLinking,
+            EntryCategoryType::Spawn,
+            EntryCategoryType::Exec,
+        ] {
+            let config = TestConfig::new(&auth, t, 1);
+            let mut data_loader = DummyDataLoader::new();
+            let tx = gen_tx(&mut data_loader, &config);
+            let tx = sign_tx(tx, &config);
+            let verifier = gen_tx_scripts_verifier(tx, data_loader);
+            let cycles = verifier
+                .verify(MAX_CYCLES)
+                .map_err(|e| anyhow!("calibrate algorithm {}: {}", auth.get_algorithm_type(), e))?;
+            table.push(CyclesSample {
+                algorithm_id: auth.get_algorithm_type(),
+                entry_category: t as u8,
+                signature_size,
+                cycles,
+            });
+        }
+    }
+    Ok(table)
+}
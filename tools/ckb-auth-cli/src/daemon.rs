@@ -0,0 +1,259 @@
+use crate::auth_script::run_auth;
+use anyhow::{anyhow, Error};
+use clap::{arg, value_parser, ArgMatches, Command};
+use std::collections::{BTreeMap, HashMap};
+use std::io::{ErrorKind, Read, Write};
+use std::os::unix::net::{UnixListener, UnixStream};
+use std::sync::{mpsc, Arc, Mutex};
+use std::{fs, thread};
+
+// Framing, all integers little endian:
+//
+// request:  length(4) | request id(4) | algorithm id(1) | pubkey hash(20) |
+//           message length(2) | message | signature
+//           length counts the bytes following it
+// response: request id(4) | code(4) | cached(1)
+//           code is the exit code of build/auth, 0 on success, or one of
+//           the CODE_* values below
+//
+// Requests of one connection are verified concurrently, responses are written
+// as they complete and matched by request id. A malformed frame closes the
+// connection.
+pub const REQUEST_HEADER_SIZE: usize = 4 + 1 + 20 + 2;
+pub const RESPONSE_SIZE: usize = 4 + 4 + 1;
+pub const MAX_REQUEST_SIZE: usize = 64 * 1024;
+// Reported when ckb-vm fails to run build/auth, out of the exit code range.
+pub const CODE_VM_ERROR: i32 = 256;
+// Reported when build/auth doesn't finish within MAX_CYCLES.
+pub const CODE_CYCLES_EXCEEDED: i32 = 257;
+
+pub fn reg_daemon_args(cmd: Command) -> Command {
+    cmd.arg(arg!(-s --socket <SOCKET> "The unix socket to listen on"))
+        .arg(
+            arg!(-t --threads <THREADS> "Verification threads, the number of CPUs by default")
+                .value_parser(value_parser!(usize))
+                .required(false),
+        )
+        .arg(
+            arg!(-c --cache <CACHE> "Verification results to remember")
+                .value_parser(value_parser!(usize))
+                .default_value("65536"),
+        )
+}
+
+pub fn daemon(operate_mathches: &ArgMatches) -> Result<(), Error> {
+    let socket = operate_mathches
+        .get_one::<String>("socket")
+        .expect("get daemon socket");
+    let threads = match operate_mathches.get_one::<usize>("threads") {
+        Some(t) => *t,
+        None => thread::available_parallelism()?.get(),
+    };
+    let capacity = *operate_mathches
+        .get_one::<usize>("cache")
+        .expect("get daemon cache");
+
+    // a socket left by a previous run
+    if fs::metadata(socket).is_ok() {
+        fs::remove_file(socket)?;
+    }
+    let listener = UnixListener::bind(socket).map_err(|e| anyhow!("bind {}: {}", socket, e))?;
+    let pool = ThreadPool::new(threads.max(1));
+    let cache = Arc::new(Mutex::new(ResultCache::new(capacity)));
+    println!("listening on {}, {} threads", socket, threads);
+
+    for stream in listener.incoming() {
+        let stream = match stream {
+            Ok(s) => s,
+            Err(e) => {
+                eprintln!("accept: {}", e);
+                continue;
+            }
+        };
+        let pool = pool.clone();
+        let cache = cache.clone();
+        thread::spawn(move || {
+            if let Err(e) = serve(stream, pool, cache) {
+                eprintln!("connection: {}", e);
+            }
+        });
+    }
+    Ok(())
+}
+
+pub struct Request {
+    pub id: u32,
+    pub algorithm_id: u8,
+    pub pubkey_hash: [u8; 20],
+    pub message: Vec<u8>,
+    pub signature: Vec<u8>,
+}
+
+impl Request {
+    pub fn parse(body: &[u8]) -> Result<Request, Error> {
+        if body.len() < REQUEST_HEADER_SIZE {
+            return Err(anyhow!("request too short"));
+        }
+        let message_len = u16::from_le_bytes([body[25], body[26]]) as usize;
+        if body.len() < REQUEST_HEADER_SIZE + message_len {
+            return Err(anyhow!("request shorter than its message"));
+        }
+        let (message, signature) = body[REQUEST_HEADER_SIZE..].split_at(message_len);
+        Ok(Request {
+            id: u32::from_le_bytes(body[0..4].try_into().unwrap()),
+            algorithm_id: body[4],
+            pubkey_hash: body[5..25].try_into().unwrap(),
+            message: message.to_vec(),
+            signature: signature.to_vec(),
+        })
+    }
+
+    // Request ids are chosen by clients and aren't part of the key.
+    fn cache_key(&self) -> [u8; 32] {
+        let size = 1 + 20 + 2 + self.message.len() + self.signature.len();
+        let mut data = Vec::with_capacity(size);
+        data.push(self.algorithm_id);
+        data.extend_from_slice(&self.pubkey_hash);
+        data.extend_from_slice(&(self.message.len() as u16).to_le_bytes());
+        data.extend_from_slice(&self.message);
+        data.extend_from_slice(&self.signature);
+        ckb_hash::blake2b_256(data)
+    }
+}
+
+fn serve(
+    mut stream: UnixStream,
+    pool: ThreadPool,
+    cache: Arc<Mutex<ResultCache>>,
+) -> Result<(), Error> {
+    let writer = Arc::new(Mutex::new(stream.try_clone()?));
+    loop {
+        let mut length = [0u8; 4];
+        match stream.read_exact(&mut length) {
+            Ok(()) => {}
+            Err(e) if e.kind() == ErrorKind::UnexpectedEof => return Ok(()),
+            Err(e) => return Err(e.into()),
+        }
+        let length = u32::from_le_bytes(length) as usize;
+        if length > MAX_REQUEST_SIZE {
+            return Err(anyhow!("request of {} bytes", length));
+        }
+        let mut body = vec![0u8; length];
+        stream.read_exact(&mut body)?;
+        let request = Request::parse(&body)?;
+
+        let writer = writer.clone();
+        let cache = cache.clone();
+        pool.execute(move || {
+            let (code, cached) = verify_cached(&cache, &request);
+            let mut response = [0u8; RESPONSE_SIZE];
+            response[0..4].copy_from_slice(&request.id.to_le_bytes());
+            response[4..8].copy_from_slice(&code.to_le_bytes());
+            response[8] = cached as u8;
+            // the client may be gone, its other responses fail the same way
+            let _ = writer.lock().unwrap().write_all(&response);
+        });
+    }
+}
+
+// Verification is deterministic, failures are remembered as well as
+// successes, and so is running out of cycles. Other VM errors aren't, they
+// don't depend on the request only.
+fn verify_cached(cache: &Mutex<ResultCache>, request: &Request) -> (i32, bool) {
+    let key = request.cache_key();
+    if let Some(code) = cache.lock().unwrap().get(&key) {
+        return (code, true);
+    }
+    match run_auth(
+        request.algorithm_id,
+        &request.pubkey_hash,
+        &request.message,
+        &request.signature,
+    ) {
+        Ok(exit) => {
+            let code = exit as i32;
+            cache.lock().unwrap().insert(key, code);
+            (code, false)
+        }
+        Err(ckb_vm::Error::CyclesExceeded) => {
+            cache.lock().unwrap().insert(key, CODE_CYCLES_EXCEEDED);
+            (CODE_CYCLES_EXCEEDED, false)
+        }
+        Err(e) => {
+            eprintln!("request {}: {:?}", request.id, e);
+            (CODE_VM_ERROR, false)
+        }
+    }
+}
+
+// Least recently used results, ordered by the tick of their last use.
+struct ResultCache {
+    capacity: usize,
+    tick: u64,
+    entries: HashMap<[u8; 32], (i32, u64)>,
+    order: BTreeMap<u64, [u8; 32]>,
+}
+
+impl ResultCache {
+    fn new(capacity: usize) -> ResultCache {
+        ResultCache {
+            capacity,
+            tick: 0,
+            entries: HashMap::new(),
+            order: BTreeMap::new(),
+        }
+    }
+
+    fn get(&mut self, key: &[u8; 32]) -> Option<i32> {
+        self.tick += 1;
+        let entry = self.entries.get_mut(key)?;
+        self.order.remove(&entry.1);
+        entry.1 = self.tick;
+        self.order.insert(self.tick, *key);
+        Some(entry.0)
+    }
+
+    fn insert(&mut self, key: [u8; 32], code: i32) {
+        if self.capacity == 0 {
+            return;
+        }
+        self.tick += 1;
+        if let Some((_, tick)) = self.entries.insert(key, (code, self.tick)) {
+            self.order.remove(&tick);
+        }
+        self.order.insert(self.tick, key);
+        while self.entries.len() > self.capacity {
+            let (_, oldest) = self.order.pop_first().unwrap();
+            self.entries.remove(&oldest);
+        }
+    }
+}
+
+type Job = Box<dyn FnOnce() + Send>;
+
+#[derive(Clone)]
+struct ThreadPool {
+    sender: mpsc::Sender<Job>,
+}
+
+impl ThreadPool {
+    fn new(size: usize) -> ThreadPool {
+        let (sender, receiver) = mpsc::channel::<Job>();
+        let receiver = Arc::new(Mutex::new(receiver));
+        for _ in 0..size {
+            let receiver = receiver.clone();
+            thread::spawn(move || loop {
+                let job = match receiver.lock().unwrap().recv() {
+                    Ok(job) => job,
+                    Err(_) => break,
+                };
+                job();
+            });
+        }
+        ThreadPool { sender }
+    }
+
+    fn execute<F: FnOnce() + Send + 'static>(&self, f: F) {
+        self.sender.send(Box::new(f)).expect("thread pool is gone");
+    }
+}
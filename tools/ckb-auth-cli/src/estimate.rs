@@ -0,0 +1,111 @@
+// Cycle estimates from a calibration table written by `ckb-auth-cli
+// calibrate`, for wallets budgeting the fee of an auth entry. Depends on
+// nothing but the table, so it can be used without build/auth.
+use anyhow::{anyhow, Error};
+use serde_json::{json, Value};
+use std::fs;
+
+// One measured run of build/auth: the cycles consumed by the whole lock
+// script for a given algorithm id, entry category and signature size.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct CyclesSample {
+    pub algorithm_id: u8,
+    pub entry_category: u8,
+    pub signature_size: usize,
+    pub cycles: u64,
+}
+
+// Estimates the cycles of an auth entry from the calibration table. Sizes
+// that were not measured are linearly interpolated between the nearest
+// samples of the same algorithm id and entry category, or extrapolated from
+// the two largest ones, rounding up since the result is used to budget fees.
+// Sizes below the smallest sample get its cycles: extrapolating down could
+// under-estimate.
+pub fn estimate_cycles(
+    table: &[CyclesSample],
+    algorithm_id: u8,
+    entry_category: u8,
+    signature_size: usize,
+) -> Result<u64, Error> {
+    let mut points: Vec<(usize, u64)> = table
+        .iter()
+        .filter(|s| s.algorithm_id == algorithm_id && s.entry_category == entry_category)
+        .map(|s| (s.signature_size, s.cycles))
+        .collect();
+    if points.is_empty() {
+        return Err(anyhow!(
+            "no calibration data for algorithm {} entry category {}",
+            algorithm_id,
+            entry_category
+        ));
+    }
+    points.sort();
+    // keep the most expensive run per size
+    points.reverse();
+    points.dedup_by_key(|p| p.0);
+    points.reverse();
+
+    if let Some(p) = points.iter().find(|p| p.0 == signature_size) {
+        return Ok(p.1);
+    }
+    if points.len() == 1 || signature_size < points[0].0 {
+        return Ok(points[0].1);
+    }
+
+    let i = match points.iter().position(|p| p.0 > signature_size) {
+        Some(i) => i - 1,
+        None => points.len() - 2,
+    };
+    let (x0, y0) = points[i];
+    let (x1, y1) = points[i + 1];
+    let slope = (y1 as f64 - y0 as f64) / (x1 as f64 - x0 as f64);
+    let cycles = y0 as f64 + slope * (signature_size as f64 - x0 as f64);
+    Ok(cycles.max(0.0).ceil() as u64)
+}
+
+pub fn load_table(path: &str) -> Result<Vec<CyclesSample>, Error> {
+    let content = fs::read_to_string(path).map_err(|e| {
+        anyhow!(
+            "read calibration table {}: {}, run `ckb-auth-cli calibrate` first",
+            path,
+            e
+        )
+    })?;
+    let value: Value = serde_json::from_str(&content)?;
+    let samples = value
+        .as_array()
+        .ok_or_else(|| anyhow!("calibration table is not an array"))?;
+
+    let field = |s: &Value, name: &str| -> Result<u64, Error> {
+        s.get(name)
+            .and_then(|v| v.as_u64())
+            .ok_or_else(|| anyhow!("calibration sample without {}", name))
+    };
+    samples
+        .iter()
+        .map(|s| {
+            Ok(CyclesSample {
+                algorithm_id: field(s, "algorithm_id")? as u8,
+                entry_category: field(s, "entry_category")? as u8,
+                signature_size: field(s, "signature_size")? as usize,
+                cycles: field(s, "cycles")?,
+            })
+        })
+        .collect()
+}
+
+pub fn save_table(path: &str, table: &[CyclesSample]) -> Result<(), Error> {
+    let value: Vec<Value> = table
+        .iter()
+        .map(|s| {
+            json!({
+                "algorithm_id": s.algorithm_id,
+                "entry_category": s.entry_category,
+                "signature_size": s.signature_size,
+                "cycles": s.cycles,
+            })
+        })
+        .collect();
+    fs::write(path, serde_json::to_string_pretty(&value)?)?;
+    Ok(())
+}
@@ -1,9 +1,9 @@
 use super::{BlockChain, BlockChainArgs};
 use anyhow::{anyhow, Error};
 use ckb_auth_rs::{
-    auth_builder, debug_printer, gen_tx_scripts_verifier, gen_tx_with_pub_key_hash,
-    get_message_to_sign, set_signature, AlgorithmType, DummyDataLoader, EntryCategoryType,
-    TestConfig, MAX_CYCLES,
+    auth_builder, compact_btc_signature, debug_printer, gen_tx_scripts_verifier,
+    gen_tx_with_pub_key_hash, get_message_to_sign, set_signature, AlgorithmType, Auth,
+    CompactSignatureAuth, DummyDataLoader, EntryCategoryType, TestConfig, MAX_CYCLES,
 };
 use clap::{arg, ArgMatches, Command};
 use hex::{decode, encode};
@@ -20,12 +20,14 @@ impl BlockChainArgs for LitecoinLockArgs {
     fn reg_generate_args(&self, cmd: Command) -> Command {
         cmd .arg(arg!(-a --address <ADDRESS> "The pubkey address whose hash will be included in the message").required(false))
       .arg(arg!(-p --pubkeyhash <PUBKEYHASH> "The pubkey hash to include in the message").required(false))
+      .arg(arg!(--compact "The signature will be put in the witness as an EIP-2098 compact one"))
     }
     fn reg_verify_args(&self, cmd: Command) -> Command {
         cmd .arg(arg!(-a --address <ADDRESS> "The pubkey address whose hash verify against"))
       .arg(arg!(-p --pubkeyhash <PUBKEYHASH> "The pubkey hash to verify against"))
       .arg(arg!(-s --signature <SIGNATURE> "The signature to verify"))
       .arg(arg!(-e --encoding <ENCODING> "The encoding of the signature (may be hex or base64)"))
+      .arg(arg!(--compact "Put the signature in the witness as an EIP-2098 compact one"))
     }
 
     fn get_block_chain(&self) -> Box<dyn BlockChain> {
@@ -60,7 +62,10 @@ impl BlockChain for LitecoinLock {
         // This is not intended as the litecoin-cli will do the conversion internally,
         // and then sign the converted message. With official set to be true, we don't
         // do this kind of conversion in the auth data structure.
-        let auth = auth_builder(AlgorithmType::Litecoin, true).unwrap();
+        let auth = with_compact(
+            auth_builder(AlgorithmType::Litecoin, true).unwrap(),
+            operate_mathches,
+        );
         let config = TestConfig::new(&auth, run_type, 1);
         let mut data_loader = DummyDataLoader::new();
         let tx = gen_tx_with_pub_key_hash(&mut data_loader, &config, pubkey_hash.to_vec());
@@ -85,11 +90,18 @@ impl BlockChain for LitecoinLock {
 
         let algorithm_type = AlgorithmType::Litecoin;
         let run_type = EntryCategoryType::Spawn;
-        let auth = auth_builder(algorithm_type, false).unwrap();
+        let auth = with_compact(
+            auth_builder(algorithm_type, false).unwrap(),
+            operate_mathches,
+        );
         let config = TestConfig::new(&auth, run_type, 1);
         let mut data_loader = DummyDataLoader::new();
         let tx = gen_tx_with_pub_key_hash(&mut data_loader, &config, pubkey_hash.to_vec());
-        let signature = signature.into();
+        let signature = if operate_mathches.get_flag("compact") {
+            compact_btc_signature(&signature)
+        } else {
+            signature.into()
+        };
         let tx = set_signature(tx, &signature);
         let mut verifier = gen_tx_scripts_verifier(tx, data_loader);
 
@@ -105,6 +117,16 @@ impl BlockChain for LitecoinLock {
     }
 }
 
+// The message to sign covers the witness size, generate and verify must agree
+// on the signature encoding.
+fn with_compact(auth: Box<dyn Auth>, sub_matches: &ArgMatches) -> Box<dyn Auth> {
+    if sub_matches.get_flag("compact") {
+        CompactSignatureAuth::new(auth)
+    } else {
+        auth
+    }
+}
+
 fn get_pubkey_hash_by_args(sub_matches: &ArgMatches) -> Result<[u8; 20], Error> {
     let pubkey_hash: Option<&String> = sub_matches.get_one::<String>("pubkeyhash");
     let pubkey_hash: [u8; 20] = if pubkey_hash.is_some() {
@@ -1,9 +1,16 @@
 mod auth_script;
+mod bulk;
 mod cardano;
+mod cycles;
+mod daemon;
 mod litecoin;
+mod mock_tx;
 mod monero;
+mod profile;
+mod replay;
 mod solana;
 mod utils;
+mod worst_case;
 
 use crate::monero::MoneroLockArgs;
 use cardano::CardanoLockArgs;
@@ -63,7 +70,41 @@ fn cli(block_chain_args: &[Box<dyn BlockChainArgs>]) -> Command {
         );
     }
 
-    cmd
+    cmd.subcommand(cycles::reg_estimate_args(
+        Command::new("estimate")
+            .about("Estimate the cycles of an auth entry from the calibration table")
+            .arg_required_else_help(true),
+    ))
+    .subcommand(cycles::reg_calibrate_args(Command::new("calibrate").about(
+        "Run build/auth for every algorithm and write the calibration table",
+    )))
+    .subcommand(profile::reg_profile_args(
+        Command::new("profile")
+            .about("Run build/auth and attribute cycles to its functions")
+            .arg_required_else_help(true),
+    ))
+    .subcommand(daemon::reg_daemon_args(
+        Command::new("daemon")
+            .about("Verify requests from a unix socket, remembering the results")
+            .arg_required_else_help(true),
+    ))
+    .subcommand(bulk::reg_bulk_generate_args(
+        Command::new("bulk-generate")
+            .about("Write signed mock transactions for load testing, in parallel")
+            .arg_required_else_help(true),
+    ))
+    .subcommand(replay::reg_replay_args(
+        Command::new("replay")
+            .about("Replay mock transactions and report their cycles per script group")
+            .subcommand_required(true)
+            .arg_required_else_help(true),
+    ))
+    .subcommand(worst_case::reg_worst_case_args(
+        Command::new("worst-case")
+            .about("Search for and check the signatures costing build/auth the most cycles")
+            .subcommand_required(true)
+            .arg_required_else_help(true),
+    ))
 }
 
 // fn print_pubkey_hash(pubkey: &[u8]) {
@@ -83,6 +124,17 @@ fn main() -> Result<(), Error> {
 
     let (block_chain_name, sub_matches) = matches.subcommand().expect("get subcommand");
 
+    match block_chain_name {
+        "estimate" => return cycles::estimate(sub_matches),
+        "calibrate" => return cycles::calibrate(sub_matches),
+        "profile" => return profile::profile(sub_matches),
+        "daemon" => return daemon::daemon(sub_matches),
+        "bulk-generate" => return bulk::bulk_generate(sub_matches),
+        "replay" => return replay::replay(sub_matches),
+        "worst-case" => return worst_case::worst_case(sub_matches),
+        _ => {}
+    }
+
     let subcommand = block_chain_args
         .iter()
         .find(|f| f.block_chain_name() == block_chain_name)
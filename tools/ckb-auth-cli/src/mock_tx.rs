@@ -0,0 +1,136 @@
+use anyhow::{anyhow, Error};
+use ckb_auth_rs::DummyDataLoader;
+use ckb_jsonrpc_types::{CellDep, CellInput, CellOutput, JsonBytes, Transaction};
+use ckb_types::core::{DepType, TransactionView};
+use ckb_types::packed;
+use ckb_types::prelude::*;
+use serde::{Deserialize, Serialize};
+use serde_json::Value;
+use std::fs;
+
+// The mock transaction format of ckb-debugger (ReprMockTransaction in
+// ckb-mock-tx-types): a transaction together with every cell it reads, so
+// it can be verified without a chain. Headers aren't used by build/auth and
+// are passed through as they are.
+#[derive(Clone, Serialize, Deserialize)]
+pub struct MockInput {
+    pub input: CellInput,
+    pub output: CellOutput,
+    pub data: JsonBytes,
+    #[serde(default)]
+    pub header: Option<Value>,
+}
+
+#[derive(Clone, Serialize, Deserialize)]
+pub struct MockCellDep {
+    pub cell_dep: CellDep,
+    pub output: CellOutput,
+    pub data: JsonBytes,
+    #[serde(default)]
+    pub header: Option<Value>,
+}
+
+#[derive(Clone, Serialize, Deserialize)]
+pub struct MockInfo {
+    pub inputs: Vec<MockInput>,
+    pub cell_deps: Vec<MockCellDep>,
+    #[serde(default)]
+    pub header_deps: Vec<Value>,
+}
+
+#[derive(Clone, Serialize, Deserialize)]
+pub struct MockTransaction {
+    pub mock_info: MockInfo,
+    pub tx: Transaction,
+}
+
+impl MockTransaction {
+    pub fn from_tx(tx: &TransactionView, data_loader: &DummyDataLoader) -> Result<Self, Error> {
+        let cell = |out_point: &packed::OutPoint| {
+            data_loader
+                .cells
+                .get(out_point)
+                .ok_or_else(|| anyhow!("cell {} is not in the data loader", out_point))
+        };
+        let inputs = tx
+            .inputs()
+            .into_iter()
+            .map(|input| {
+                let (output, data) = cell(&input.previous_output())?;
+                Ok(MockInput {
+                    input: input.into(),
+                    output: output.clone().into(),
+                    data: JsonBytes::from_bytes(data.clone()),
+                    header: None,
+                })
+            })
+            .collect::<Result<Vec<_>, Error>>()?;
+        let cell_deps = tx
+            .cell_deps()
+            .into_iter()
+            .map(|cell_dep| {
+                let (output, data) = cell(&cell_dep.out_point())?;
+                Ok(MockCellDep {
+                    cell_dep: cell_dep.into(),
+                    output: output.clone().into(),
+                    data: JsonBytes::from_bytes(data.clone()),
+                    header: None,
+                })
+            })
+            .collect::<Result<Vec<_>, Error>>()?;
+        Ok(MockTransaction {
+            mock_info: MockInfo {
+                inputs,
+                cell_deps,
+                header_deps: vec![],
+            },
+            tx: tx.data().into(),
+        })
+    }
+
+    // The transaction and a data loader holding the cells it reads, as
+    // gen_tx_scripts_verifier takes them.
+    pub fn resolve(&self) -> Result<(TransactionView, DummyDataLoader), Error> {
+        let mut data_loader = DummyDataLoader::new();
+        for i in &self.mock_info.inputs {
+            let input: packed::CellInput = i.input.clone().into();
+            data_loader.cells.insert(
+                input.previous_output(),
+                (i.output.clone().into(), i.data.clone().into_bytes()),
+            );
+        }
+        for d in &self.mock_info.cell_deps {
+            let cell_dep: packed::CellDep = d.cell_dep.clone().into();
+            data_loader.cells.insert(
+                cell_dep.out_point(),
+                (d.output.clone().into(), d.data.clone().into_bytes()),
+            );
+        }
+
+        let tx = packed::Transaction::from(self.tx.clone()).into_view();
+        for input in tx.inputs() {
+            if !data_loader.cells.contains_key(&input.previous_output()) {
+                return Err(anyhow!("input {} is not mocked", input.previous_output()));
+            }
+        }
+        for cell_dep in tx.cell_deps() {
+            if !data_loader.cells.contains_key(&cell_dep.out_point()) {
+                return Err(anyhow!("cell dep {} is not mocked", cell_dep.out_point()));
+            }
+            if u8::from(cell_dep.dep_type()) != DepType::Code as u8 {
+                return Err(anyhow!("dep group cell deps are not supported"));
+            }
+        }
+        Ok((tx, data_loader))
+    }
+
+    pub fn load(path: &str) -> Result<Self, Error> {
+        let content = fs::read_to_string(path).map_err(|e| anyhow!("read {}: {}", path, e))?;
+        serde_json::from_str(&content).map_err(|e| anyhow!("parse {}: {}", path, e))
+    }
+
+    pub fn save(&self, path: &str) -> Result<(), Error> {
+        fs::write(path, serde_json::to_string_pretty(self)?)?;
+        Ok(())
+    }
+}
@@ -0,0 +1,279 @@
+use crate::auth_script::{CellDepSyscall, DebugSyscall, AUTH_CODE};
+use anyhow::{anyhow, Error};
+use ckb_auth_rs::{auth_builder, AlgorithmType};
+use ckb_vm::cost_model::estimate_cycles;
+use ckb_vm::decoder::build_decoder;
+use ckb_vm::{
+    Bytes, CoreMachine, DefaultCoreMachine, DefaultMachineBuilder, Memory, SparseMemory,
+    SupportMachine, WXorXMemory,
+};
+use clap::{arg, value_parser, ArgMatches, Command};
+use hex::{decode, encode};
+use std::collections::HashMap;
+use std::fmt::Write;
+use std::fs;
+
+pub const DEFAULT_DEBUG_PATH: &str = "build/auth.debug";
+
+pub fn reg_profile_args(cmd: Command) -> Command {
+    cmd.arg(
+        arg!(-a --algorithm <ALGORITHM_ID> "The algorithm id")
+            .value_parser(value_parser!(u8)),
+    )
+    .arg(arg!(-s --signature <SIGNATURE> "The signature in hex, signed with a random key when omitted").required(false))
+    .arg(arg!(-m --message <MESSAGE> "The 32 bytes message in hex").required(false))
+    .arg(arg!(-p --pubkeyhash <PUBKEYHASH> "The pubkey hash in hex").required(false))
+    .arg(arg!(-d --debug <DEBUG> "The ELF with symbols of build/auth").required(false))
+    .arg(arg!(-o --output <OUTPUT> "Write the profile to this file instead of stdout").required(false))
+    .arg(arg!(--flat "Print cycles per function instead of folded stacks"))
+}
+
+struct Symbols {
+    // (address, size, name) sorted by address
+    functions: Vec<(u64, u64, String)>,
+}
+
+impl Symbols {
+    fn load(path: &str) -> Result<Symbols, Error> {
+        let buffer = fs::read(path).map_err(|e| anyhow!("read {}: {}", path, e))?;
+        let elf = goblin::elf::Elf::parse(&buffer)?;
+        let mut functions: Vec<(u64, u64, String)> = elf
+            .syms
+            .iter()
+            .filter(|sym| sym.is_function() && sym.st_value != 0)
+            .filter_map(|sym| {
+                elf.strtab
+                    .get_at(sym.st_name)
+                    .map(|name| (sym.st_value, sym.st_size, name.to_string()))
+            })
+            .collect();
+        functions.sort();
+        if functions.is_empty() {
+            return Err(anyhow!("no function symbols in {}", path));
+        }
+        Ok(Symbols { functions })
+    }
+
+    // Index of the function containing pc, functions.len() if unknown
+    fn lookup(&self, pc: u64) -> usize {
+        let i = self.functions.partition_point(|f| f.0 <= pc);
+        if i == 0 {
+            return self.functions.len();
+        }
+        let (address, size, _) = &self.functions[i - 1];
+        if *size == 0 || pc < address + size {
+            i - 1
+        } else {
+            self.functions.len()
+        }
+    }
+
+    fn name(&self, index: usize) -> &str {
+        self.functions
+            .get(index)
+            .map(|f| f.2.as_str())
+            .unwrap_or("??")
+    }
+}
+
+enum Jump {
+    Call,
+    Return,
+    Other,
+}
+
+// Classifies the instruction at pc by its encoding. A call is jal/jalr
+// linking ra, a return is jalr x0, 0(ra); both with their compressed forms.
+fn classify(instruction: u32) -> Jump {
+    if instruction & 0x3 != 0x3 {
+        let funct4 = (instruction >> 12) & 0xf;
+        let rs1 = (instruction >> 7) & 0x1f;
+        let rs2 = (instruction >> 2) & 0x1f;
+        if instruction & 0x3 == 0x2 && rs1 != 0 && rs2 == 0 {
+            if funct4 == 0x9 {
+                return Jump::Call;
+            }
+            if funct4 == 0x8 && rs1 == 1 {
+                return Jump::Return;
+            }
+        }
+        return Jump::Other;
+    }
+    let opcode = instruction & 0x7f;
+    let rd = (instruction >> 7) & 0x1f;
+    let rs1 = (instruction >> 15) & 0x1f;
+    match opcode {
+        0x6f if rd == 1 => Jump::Call,
+        0x67 if rd == 1 => Jump::Call,
+        0x67 if rd == 0 && rs1 == 1 && instruction >> 20 == 0 => Jump::Return,
+        _ => Jump::Other,
+    }
+}
+
+pub fn profile(operate_mathches: &ArgMatches) -> Result<(), Error> {
+    let algorithm_id = *operate_mathches
+        .get_one::<u8>("algorithm")
+        .expect("get profile algorithm");
+    let debug_path = operate_mathches
+        .get_one::<String>("debug")
+        .map(|s| s.as_str())
+        .unwrap_or(DEFAULT_DEBUG_PATH);
+    let symbols = Symbols::load(debug_path)?;
+
+    let message: Vec<u8> = match operate_mathches.get_one::<String>("message") {
+        Some(m) => decode(m)?,
+        None => vec![0u8; 32],
+    };
+    let (signature, pubkey_hash) = match operate_mathches.get_one::<String>("signature") {
+        Some(s) => {
+            let pubkey_hash = operate_mathches
+                .get_one::<String>("pubkeyhash")
+                .ok_or_else(|| anyhow!("pubkeyhash is required with signature"))?;
+            (decode(s)?, decode(pubkey_hash)?)
+        }
+        None => {
+            let auth = auth_builder(get_algorithm_type(algorithm_id)?, false)
+                .map_err(|e| anyhow!("can't sign for algorithm {}: {}", algorithm_id, e))?;
+            let message: [u8; 32] = message
+                .clone()
+                .try_into()
+                .map_err(|_| anyhow!("message must be 32 bytes"))?;
+            let signature = auth.sign(&auth.convert_message(&message));
+            (signature.to_vec(), auth.get_pub_key_hash())
+        }
+    };
+
+    let (stacks, total) = run_profile(&symbols, algorithm_id, &signature, &message, &pubkey_hash)?;
+    // on stderr, so that the folded stacks can be piped as they are
+    eprintln!("{} cycles", total);
+
+    let mut output = String::new();
+    if operate_mathches.get_flag("flat") {
+        let mut flat: HashMap<usize, u64> = HashMap::new();
+        for (stack, cycles) in &stacks {
+            *flat.entry(*stack.last().unwrap()).or_default() += cycles;
+        }
+        let mut flat: Vec<(usize, u64)> = flat.into_iter().collect();
+        flat.sort_by(|a, b| b.1.cmp(&a.1));
+        for (function, cycles) in flat {
+            writeln!(output, "{:>12} {}", cycles, symbols.name(function))?;
+        }
+    } else {
+        let mut folded: Vec<(String, u64)> = stacks
+            .iter()
+            .map(|(stack, cycles)| {
+                let names: Vec<&str> = stack.iter().map(|f| symbols.name(*f)).collect();
+                (names.join(";"), *cycles)
+            })
+            .collect();
+        folded.sort();
+        for (stack, cycles) in folded {
+            writeln!(output, "{} {}", stack, cycles)?;
+        }
+    }
+
+    match operate_mathches.get_one::<String>("output") {
+        Some(path) => fs::write(path, output)?,
+        None => print!("{}", output),
+    }
+    Ok(())
+}
+
+// Runs build/auth instruction by instruction and attributes the cycles of
+// every instruction to the call stack it was executed in. The stack is
+// tracked from calls and returns; tail calls replace the innermost frame.
+// Returns the stacks and the cycles of the whole run, which they add up to.
+fn run_profile(
+    symbols: &Symbols,
+    algorithm_id: u8,
+    signature: &[u8],
+    message: &[u8],
+    pubkey_hash: &[u8],
+) -> Result<(HashMap<Vec<usize>, u64>, u64), Error> {
+    let isa = ckb_vm::ISA_IMC | ckb_vm::ISA_B | ckb_vm::ISA_MOP;
+    let version = ckb_vm::machine::VERSION1;
+    let core =
+        DefaultCoreMachine::<u64, WXorXMemory<SparseMemory<u64>>>::new(isa, version, u64::MAX);
+    let mut machine = DefaultMachineBuilder::new(core)
+        .instruction_cycle_func(Box::new(estimate_cycles))
+        .syscall(Box::new(DebugSyscall {}))
+        .syscall(Box::new(CellDepSyscall::new()))
+        .build();
+    machine
+        .load_program(
+            &AUTH_CODE,
+            &[
+                Bytes::from(format!("{:02X?}", algorithm_id)),
+                Bytes::from(encode(signature)),
+                Bytes::from(encode(message)),
+                Bytes::from(encode(pubkey_hash)),
+            ],
+        )
+        .map_err(|e| anyhow!("load build/auth: {:?}", e))?;
+
+    let mut decoder = build_decoder::<u64>(isa, version);
+    let mut stacks: HashMap<Vec<usize>, u64> = HashMap::new();
+    let mut stack = vec![symbols.lookup(*machine.pc())];
+    if machine.cycles() > 0 {
+        // charged while loading, before the first instruction
+        stacks.insert(stack.clone(), machine.cycles());
+    }
+    machine.set_running(true);
+    while machine.running() {
+        if machine.reset_signal() {
+            decoder.reset_instructions_cache();
+        }
+        let pc = *machine.pc();
+        let instruction = machine
+            .memory_mut()
+            .load32(&pc)
+            .map(|i| i as u32)
+            .or_else(|_| machine.memory_mut().load16(&pc).map(|i| i as u32))
+            .map_err(|e| anyhow!("fetch at {:x}: {:?}", pc, e))?;
+        let cycles = machine.cycles();
+        machine
+            .step(&mut decoder)
+            .map_err(|e| anyhow!("run build/auth: {:?}", e))?;
+        *stacks.entry(stack.clone()).or_default() += machine.cycles() - cycles;
+
+        let function = symbols.lookup(*machine.pc());
+        match classify(instruction) {
+            Jump::Call => stack.push(function),
+            Jump::Return if stack.len() > 1 => {
+                stack.pop();
+            }
+            _ => {}
+        }
+        *stack.last_mut().unwrap() = function;
+    }
+
+    let exit = machine.exit_code();
+    if exit != 0 {
+        return Err(anyhow!("verify failed, return code: {}", exit));
+    }
+    Ok((stacks, machine.cycles()))
+}
+
+fn get_algorithm_type(algorithm_id: u8) -> Result<AlgorithmType, Error> {
+    let algorithms = [
+        AlgorithmType::Ckb,
+        AlgorithmType::Ethereum,
+        AlgorithmType::Eos,
+        AlgorithmType::Tron,
+        AlgorithmType::Bitcoin,
+        AlgorithmType::Dogecoin,
+        AlgorithmType::SchnorrOrTaproot,
+        AlgorithmType::RSA,
+        AlgorithmType::Iso9796_2,
+        AlgorithmType::Monero,
+        AlgorithmType::Secp256r1,
+        AlgorithmType::WebAuthn,
+        AlgorithmType::Bls12381,
+        AlgorithmType::HashPreimage,
+        AlgorithmType::Composite,
+    ];
+    algorithms
+        .into_iter()
+        .find(|t| *t as u8 == algorithm_id)
+        .ok_or_else(|| anyhow!("algorithm {} needs an external signer", algorithm_id))
+}
@@ -0,0 +1,301 @@
+use crate::cycles::calibration_auths;
+use crate::mock_tx::MockTransaction;
+use anyhow::{anyhow, Error};
+use ckb_auth_rs::{
+    auth_builder, gen_args, gen_tx_scripts_verifier, gen_tx_with_grouped_args, set_key_seed,
+    sign_tx, sign_tx_by_input_group, AlgorithmType, Auth, Bls12381Auth, DummyDataLoader,
+    EntryCategoryType, TestConfig, MAX_CYCLES, RNG_SEED,
+};
+use ckb_script::ScriptGroupType;
+use ckb_types::core::TransactionView;
+use clap::{arg, value_parser, ArgMatches, Command};
+use rand::{rngs::SmallRng, SeedableRng};
+use serde_json::{json, Map, Value};
+use std::collections::BTreeMap;
+use std::fs;
+use std::path::Path;
+
+pub const DEFAULT_CORPUS_PATH: &str = "build/replay";
+pub const DEFAULT_BASELINE_PATH: &str = "tools/ckb-auth-cli/tests/replay/baseline.json";
+
+pub fn reg_replay_args(cmd: Command) -> Command {
+    cmd.subcommand(
+        Command::new("corpus")
+            .about("Write signed mock transactions for every algorithm and entry category")
+            .arg(arg!(-d --dir <DIR> "The directory to write to").required(false)),
+    )
+    .subcommand(
+        Command::new("run")
+            .about("Verify every mock transaction of a directory and compare with a baseline")
+            .arg(arg!(-d --dir <DIR> "The directory of mock transactions").required(false))
+            .arg(arg!(-b --baseline <BASELINE> "The baseline cycles").required(false))
+            .arg(arg!(--save "Write the cycles as the new baseline instead of comparing"))
+            .arg(
+                arg!(-t --tolerance <PERCENT> "Allowed increase over the baseline, in percent")
+                    .value_parser(value_parser!(u64))
+                    .default_value("1"),
+            ),
+    )
+}
+
+pub fn replay(operate_mathches: &ArgMatches) -> Result<(), Error> {
+    match operate_mathches.subcommand() {
+        Some(("corpus", m)) => corpus(m),
+        Some(("run", m)) => run(m),
+        _ => Err(anyhow!("unsupported operate")),
+    }
+}
+
+fn get_dir(operate_mathches: &ArgMatches) -> &str {
+    operate_mathches
+        .get_one::<String>("dir")
+        .map(|s| s.as_str())
+        .unwrap_or(DEFAULT_CORPUS_PATH)
+}
+
+fn category_name(t: EntryCategoryType) -> &'static str {
+    match t {
+        EntryCategoryType::Exec => "exec",
+        EntryCategoryType::DynamicLinking => "dl",
+        EntryCategoryType::Spawn => "spawn",
+    }
+}
+
+const CATEGORIES: [EntryCategoryType; 3] = [
+    EntryCategoryType::DynamicLinking,
+    EntryCategoryType::Spawn,
+    EntryCategoryType::Exec,
+];
+
+fn gen_tx(
+    data_loader: &mut DummyDataLoader,
+    config: &TestConfig,
+    rng: &mut SmallRng,
+) -> TransactionView {
+    gen_tx_with_grouped_args(
+        data_loader,
+        vec![(gen_args(config), config.sign_size as usize)],
+        rng,
+    )
+}
+
+// One transaction per auth of the calibration set and entry category, named
+// <algorithm id>-<category>-<signature size>.json, plus transactions with
+// several inputs: one lock group spending 3 cells, and a 4 inputs transaction
+// mixing algorithms as a wallet consolidating its cells would. Keys and
+// transactions are derived from RNG_SEED, so a corpus written again against
+// the same build/auth replays with the same cycles as the baseline.
+fn corpus(operate_mathches: &ArgMatches) -> Result<(), Error> {
+    let dir = get_dir(operate_mathches);
+    fs::create_dir_all(dir)?;
+    set_key_seed(Some(RNG_SEED));
+    let mut rng = SmallRng::seed_from_u64(RNG_SEED);
+    let mut count = 0;
+    let mut write =
+        |name: String, tx: TransactionView, data_loader: &DummyDataLoader| -> Result<(), Error> {
+            let path = Path::new(dir).join(name);
+            MockTransaction::from_tx(&tx, data_loader)?.save(path.to_str().unwrap())?;
+            count += 1;
+            Ok(())
+        };
+
+    for auth in calibration_auths() {
+        let signature_size = auth.sign(&auth.convert_message(&[0u8; 32])).len();
+        for t in CATEGORIES {
+            let config = TestConfig::new(&auth, t, 1);
+            let mut data_loader = DummyDataLoader::new();
+            let tx = sign_tx(gen_tx(&mut data_loader, &config, &mut rng), &config);
+            let name = format!(
+                "{}-{}-{}.json",
+                auth.get_algorithm_type(),
+                category_name(t),
+                signature_size
+            );
+            write(name, tx, &data_loader)?;
+        }
+    }
+
+    for t in CATEGORIES {
+        let auth = auth_builder(AlgorithmType::Ckb, false).unwrap();
+        let config = TestConfig::new(&auth, t, 3);
+        let mut data_loader = DummyDataLoader::new();
+        let tx = sign_tx(gen_tx(&mut data_loader, &config, &mut rng), &config);
+        let name = format!(
+            "{}-{}-3inputs.json",
+            AlgorithmType::Ckb as u8,
+            category_name(t)
+        );
+        write(name, tx, &data_loader)?;
+
+        // (auth, inputs) per lock group
+        let groups: Vec<(Box<dyn Auth>, usize)> = vec![
+            (auth_builder(AlgorithmType::Ckb, false).unwrap(), 2),
+            (auth_builder(AlgorithmType::Ethereum, false).unwrap(), 1),
+            (Bls12381Auth::new_with(3), 1),
+        ];
+        let configs: Vec<TestConfig> = groups
+            .iter()
+            .map(|(auth, inputs)| TestConfig::new(auth, t, *inputs as i32))
+            .collect();
+        let mut data_loader = DummyDataLoader::new();
+        let mut tx = gen_tx_with_grouped_args(
+            &mut data_loader,
+            configs
+                .iter()
+                .map(|c| (gen_args(c), c.sign_size as usize))
+                .collect(),
+            &mut rng,
+        );
+        let mut begin = 0;
+        for c in &configs {
+            tx = sign_tx_by_input_group(tx, c, begin, c.sign_size as usize);
+            begin += c.sign_size as usize;
+        }
+        write(
+            format!("mixed-{}-4inputs.json", category_name(t)),
+            tx,
+            &data_loader,
+        )?;
+    }
+    println!("{} mock transactions written to {}", count, dir);
+    Ok(())
+}
+
+// Cycles of one mock transaction: the total and per script group, groups
+// being named after their kind and first input (or output), which unlike
+// the script hash stays the same when the corpus is written again.
+struct Replayed {
+    total: u64,
+    groups: BTreeMap<String, u64>,
+}
+
+fn replay_file(path: &str) -> Result<Replayed, Error> {
+    let (tx, data_loader) = MockTransaction::load(path)?.resolve()?;
+    let verifier = gen_tx_scripts_verifier(tx, data_loader);
+    let groups: Vec<_> = verifier
+        .groups_with_type()
+        .map(|(group_type, hash, group)| {
+            let kind = match group_type {
+                ScriptGroupType::Lock => "lock",
+                ScriptGroupType::Type => "type",
+            };
+            let position = match group.input_indices.first() {
+                Some(i) => format!("input {}", i),
+                None => format!("output {}", group.output_indices[0]),
+            };
+            (
+                group_type,
+                hash.clone(),
+                format!("{} of {}", kind, position),
+            )
+        })
+        .collect();
+
+    let mut replayed = Replayed {
+        total: 0,
+        groups: BTreeMap::new(),
+    };
+    for (group_type, hash, name) in groups {
+        let cycles = verifier
+            .verify_single(group_type, &hash, MAX_CYCLES)
+            .map_err(|e| anyhow!("{}, {}: {}", path, name, e))?;
+        replayed.total += cycles;
+        replayed.groups.insert(name, cycles);
+    }
+    Ok(replayed)
+}
+
+fn delta(cycles: u64, baseline: Option<u64>) -> String {
+    match baseline {
+        Some(b) if b > 0 => {
+            let percent = (cycles as f64 - b as f64) * 100.0 / b as f64;
+            format!(" ({:+.2}% from {})", percent, b)
+        }
+        Some(_) => String::new(),
+        None => " (new)".to_string(),
+    }
+}
+
+fn run(operate_mathches: &ArgMatches) -> Result<(), Error> {
+    let dir = get_dir(operate_mathches);
+    let baseline_path = operate_mathches
+        .get_one::<String>("baseline")
+        .map(|s| s.as_str())
+        .unwrap_or(DEFAULT_BASELINE_PATH);
+    let save = operate_mathches.get_flag("save");
+    let tolerance = *operate_mathches.get_one::<u64>("tolerance").unwrap();
+
+    let mut files: Vec<String> = fs::read_dir(dir)
+        .map_err(|e| anyhow!("read {}: {}", dir, e))?
+        .filter_map(|entry| entry.ok())
+        .map(|entry| entry.file_name().to_string_lossy().to_string())
+        .filter(|name| name.ends_with(".json"))
+        .collect();
+    files.sort();
+    if files.is_empty() {
+        return Err(anyhow!(
+            "no mock transactions in {}, run `ckb-auth-cli replay corpus` first",
+            dir
+        ));
+    }
+
+    let baseline: Value = if !save && fs::metadata(baseline_path).is_ok() {
+        serde_json::from_str(&fs::read_to_string(baseline_path)?)?
+    } else {
+        json!({})
+    };
+    let baseline_cycles = |file: &str, group: Option<&str>| -> Option<u64> {
+        let entry = baseline.get(file)?;
+        match group {
+            Some(g) => entry.get("groups")?.get(g)?.as_u64(),
+            None => entry.get("total")?.as_u64(),
+        }
+    };
+    let exceeds = |cycles: u64, baseline: Option<u64>| match baseline {
+        Some(b) => cycles > b + b * tolerance / 100,
+        None => false,
+    };
+
+    let mut record = Map::new();
+    let mut total = 0;
+    let mut regressions = 0;
+    for file in &files {
+        let path = Path::new(dir).join(file);
+        let replayed = replay_file(path.to_str().unwrap())?;
+        total += replayed.total;
+
+        let b = baseline_cycles(file, None);
+        regressions += exceeds(replayed.total, b) as usize;
+        println!(
+            "{}: {} cycles{}",
+            file,
+            replayed.total,
+            delta(replayed.total, b)
+        );
+        for (name, cycles) in &replayed.groups {
+            let b = baseline_cycles(file, Some(name));
+            regressions += exceeds(*cycles, b) as usize;
+            println!("  {}: {}{}", name, cycles, delta(*cycles, b));
+        }
+        record.insert(
+            file.clone(),
+            json!({ "total": replayed.total, "groups": replayed.groups }),
+        );
+    }
+    println!("{} transactions, {} cycles", files.len(), total);
+
+    if save {
+        if let Some(parent) = Path::new(baseline_path).parent() {
+            fs::create_dir_all(parent)?;
+        }
+        fs::write(baseline_path, serde_json::to_string_pretty(&record)?)?;
+        println!("baseline written to {}", baseline_path);
+    } else if regressions > 0 {
+        return Err(anyhow!(
+            "{} totals or script groups exceed the baseline by more than {}%",
+            regressions,
+            tolerance
+        ));
+    }
+    Ok(())
+}
@@ -0,0 +1,590 @@
+use crate::auth_script::{CellDepSyscall, DebugSyscall, AUTH_CODE};
+use anyhow::{anyhow, Error};
+use ckb_auth_rs::{
+    auth_builder, AlgorithmType, Auth, Bls12381Auth, CkbMultisigAuth, Iso97962Auth, RSAAuth,
+    RSAPadding,
+};
+use ckb_vm::cost_model::estimate_cycles;
+use ckb_vm::decoder::build_decoder;
+use ckb_vm::{
+    Bytes, CoreMachine, DefaultCoreMachine, DefaultMachineBuilder, SparseMemory, SupportMachine,
+    WXorXMemory,
+};
+use clap::{arg, value_parser, ArgAction, ArgMatches, Command};
+use hex::{decode, encode};
+use serde_json::{json, Value};
+use std::collections::HashSet;
+use std::fs;
+use std::ops::Range;
+
+pub const DEFAULT_RECORD_PATH: &str = "tests/worst_cases.json";
+// Runs are cut at this many cycles, reaching it is a finding in itself.
+pub const DEFAULT_MAX_CYCLES: u64 = 100_000_000;
+// Recorded ceilings leave this much room (in percent) above the cycles found,
+// so unrelated changes don't trip them.
+pub const CEILING_MARGIN: u64 = 10;
+const MAX_SIGNATURE_SIZE: usize = 16 * 1024;
+const MAX_CORPUS_SIZE: usize = 256;
+
+pub fn reg_worst_case_args(cmd: Command) -> Command {
+    cmd.subcommand(
+        Command::new("search")
+            .about("Mutate signatures to find the ones costing the most cycles")
+            .arg(
+                arg!(-a --algorithm <ALGORITHM_ID> "Algorithm ids to search, all locally signable ones by default")
+                    .value_parser(value_parser!(u8))
+                    .action(ArgAction::Append)
+                    .required(false),
+            )
+            .arg(
+                arg!(-n --iterations <ITERATIONS> "Runs of build/auth per algorithm")
+                    .value_parser(value_parser!(u64))
+                    .default_value("10000"),
+            )
+            .arg(
+                arg!(--seed <SEED> "Seed of the mutations, to reproduce a search")
+                    .value_parser(value_parser!(u64))
+                    .default_value("1"),
+            )
+            .arg(arg!(-s --signature <SIGNATURE> "Start from this signature in hex instead of a signed one").required(false))
+            .arg(arg!(-p --pubkeyhash <PUBKEYHASH> "The pubkey hash of --signature").required(false))
+            .arg(
+                arg!(--"max-cycles" <MAX_CYCLES> "Stop a run after this many cycles")
+                    .value_parser(value_parser!(u64))
+                    .required(false),
+            )
+            .arg(arg!(-r --record <RECORD> "Merge the worst cases into this file").required(false)),
+    )
+    .subcommand(
+        Command::new("check")
+            .about("Replay recorded worst cases and fail if one exceeds its ceiling")
+            .arg(arg!(-r --record <RECORD> "The recorded worst cases").required(false)),
+    )
+}
+
+pub fn worst_case(operate_mathches: &ArgMatches) -> Result<(), Error> {
+    match operate_mathches.subcommand() {
+        Some(("search", m)) => search(m),
+        Some(("check", m)) => check(m),
+        _ => Err(anyhow!("unsupported operate")),
+    }
+}
+
+// One recorded input of build/auth, replayed by `check`.
+#[derive(Clone, Debug)]
+pub struct WorstCase {
+    pub algorithm_id: u8,
+    pub signature: Vec<u8>,
+    pub message: Vec<u8>,
+    pub pubkey_hash: Vec<u8>,
+    pub cycles: u64,
+    pub ceiling: u64,
+}
+
+fn search(operate_mathches: &ArgMatches) -> Result<(), Error> {
+    let iterations = *operate_mathches.get_one::<u64>("iterations").unwrap();
+    let seed = *operate_mathches.get_one::<u64>("seed").unwrap();
+    let max_cycles = operate_mathches
+        .get_one::<u64>("max-cycles")
+        .copied()
+        .unwrap_or(DEFAULT_MAX_CYCLES);
+    let algorithms: Vec<u8> = match operate_mathches.get_many::<u8>("algorithm") {
+        Some(ids) => ids.copied().collect(),
+        None => SEARCHED_ALGORITHMS.iter().map(|t| *t as u8).collect(),
+    };
+
+    let mut found = vec![];
+    for algorithm_id in algorithms {
+        let (signature, pubkey_hash) = match operate_mathches.get_one::<String>("signature") {
+            Some(s) => {
+                let pubkey_hash = operate_mathches
+                    .get_one::<String>("pubkeyhash")
+                    .ok_or_else(|| anyhow!("pubkeyhash is required with signature"))?;
+                (decode(s)?, decode(pubkey_hash)?)
+            }
+            None => seed_signature(algorithm_id)?,
+        };
+        let mut searcher = Searcher {
+            algorithm_id,
+            message: vec![0u8; 32],
+            max_cycles,
+            rng: XorShift(seed.max(1)),
+            corpus: vec![],
+            edges: HashSet::new(),
+        };
+        let worst = searcher.run(signature, pubkey_hash, iterations)?;
+        println!(
+            "algorithm {}: {} cycles, {} bytes signature, {} edges",
+            algorithm_id,
+            worst.cycles,
+            worst.signature.len(),
+            searcher.edges.len()
+        );
+        found.push(worst);
+    }
+
+    if let Some(path) = operate_mathches.get_one::<String>("record") {
+        let mut record = if fs::metadata(path).is_ok() {
+            load_record(path)?
+        } else {
+            vec![]
+        };
+        for case in found {
+            match record
+                .iter_mut()
+                .find(|c| c.algorithm_id == case.algorithm_id)
+            {
+                Some(c) if c.cycles >= case.cycles => {}
+                Some(c) => *c = case,
+                None => record.push(case),
+            }
+        }
+        record.sort_by_key(|c| c.algorithm_id);
+        save_record(path, &record)?;
+        println!("{} worst cases in {}", record.len(), path);
+    }
+    Ok(())
+}
+
+fn check(operate_mathches: &ArgMatches) -> Result<(), Error> {
+    let path = operate_mathches
+        .get_one::<String>("record")
+        .map(|s| s.as_str())
+        .unwrap_or(DEFAULT_RECORD_PATH);
+    let record = load_record(path)?;
+    if record.is_empty() {
+        return Err(anyhow!(
+            "no worst cases in {}, record them with `worst-case search --record {}`",
+            path,
+            path
+        ));
+    }
+    let mut exceeded = 0;
+    for case in &record {
+        let run = replay(case)?;
+        let status = if run.cycles > case.ceiling {
+            exceeded += 1;
+            "EXCEEDED"
+        } else {
+            "ok"
+        };
+        let exit = match run.exit_code {
+            Some(code) => format!("exit code {}", code),
+            None => "cut at the ceiling".to_string(),
+        };
+        println!(
+            "algorithm {}: {} cycles, {}, recorded {}, ceiling {} {}",
+            case.algorithm_id, run.cycles, exit, case.cycles, case.ceiling, status
+        );
+    }
+    if exceeded > 0 {
+        return Err(anyhow!("{} worst cases exceed their ceiling", exceeded));
+    }
+    Ok(())
+}
+
+pub fn replay(case: &WorstCase) -> Result<Run, Error> {
+    run_auth_traced(
+        case.algorithm_id,
+        &case.signature,
+        &case.message,
+        &case.pubkey_hash,
+        case.ceiling.saturating_add(1),
+        &mut HashSet::new(),
+    )
+}
+
+pub fn load_record(path: &str) -> Result<Vec<WorstCase>, Error> {
+    let content = fs::read_to_string(path).map_err(|e| anyhow!("read {}: {}", path, e))?;
+    let value: Value = serde_json::from_str(&content)?;
+    let cases = value
+        .as_array()
+        .ok_or_else(|| anyhow!("worst cases are not an array"))?;
+    let number = |c: &Value, name: &str| -> Result<u64, Error> {
+        c.get(name)
+            .and_then(|v| v.as_u64())
+            .ok_or_else(|| anyhow!("worst case without {}", name))
+    };
+    let bytes = |c: &Value, name: &str| -> Result<Vec<u8>, Error> {
+        let s = c
+            .get(name)
+            .and_then(|v| v.as_str())
+            .ok_or_else(|| anyhow!("worst case without {}", name))?;
+        Ok(decode(s)?)
+    };
+    cases
+        .iter()
+        .map(|c| {
+            Ok(WorstCase {
+                algorithm_id: number(c, "algorithm_id")? as u8,
+                signature: bytes(c, "signature")?,
+                message: bytes(c, "message")?,
+                pubkey_hash: bytes(c, "pubkey_hash")?,
+                cycles: number(c, "cycles")?,
+                ceiling: number(c, "ceiling")?,
+            })
+        })
+        .collect()
+}
+
+pub fn save_record(path: &str, record: &[WorstCase]) -> Result<(), Error> {
+    let value: Vec<Value> = record
+        .iter()
+        .map(|c| {
+            json!({
+                "algorithm_id": c.algorithm_id,
+                "cycles": c.cycles,
+                "ceiling": c.ceiling,
+                "message": encode(&c.message),
+                "pubkey_hash": encode(&c.pubkey_hash),
+                "signature": encode(&c.signature),
+            })
+        })
+        .collect();
+    fs::write(path, serde_json::to_string_pretty(&value)? + "\n")?;
+    Ok(())
+}
+
+// Algorithms whose seed is built without an external client.
+const SEARCHED_ALGORITHMS: [AlgorithmType; 17] = [
+    AlgorithmType::Ckb,
+    AlgorithmType::Ethereum,
+    AlgorithmType::Eos,
+    AlgorithmType::Tron,
+    AlgorithmType::Bitcoin,
+    AlgorithmType::Dogecoin,
+    AlgorithmType::CkbMultisig,
+    AlgorithmType::SchnorrOrTaproot,
+    AlgorithmType::RSA,
+    AlgorithmType::Iso9796_2,
+    AlgorithmType::Monero,
+    AlgorithmType::Solana,
+    AlgorithmType::Secp256r1,
+    AlgorithmType::WebAuthn,
+    AlgorithmType::Bls12381,
+    AlgorithmType::HashPreimage,
+    AlgorithmType::Composite,
+];
+
+// A valid signature to start from, the search spends its first iterations
+// past the cheap checks this way. Variable sized ones start at their largest.
+fn seed_signature(algorithm_id: u8) -> Result<(Vec<u8>, Vec<u8>), Error> {
+    if algorithm_id == AlgorithmType::Solana as u8 {
+        return Ok(solana_seed());
+    }
+    let auth: Box<dyn Auth> = if algorithm_id == AlgorithmType::CkbMultisig as u8 {
+        CkbMultisigAuth::new(100, 100, 0)
+    } else if algorithm_id == AlgorithmType::RSA as u8 {
+        RSAAuth::new_with(4096, RSAPadding::Pkcs1V15)
+    } else if algorithm_id == AlgorithmType::Iso9796_2 as u8 {
+        Iso97962Auth::new_with(4096)
+    } else if algorithm_id == AlgorithmType::Bls12381 as u8 {
+        Bls12381Auth::new_with(8)
+    } else {
+        let algorithm_type = SEARCHED_ALGORITHMS
+            .into_iter()
+            .find(|t| *t as u8 == algorithm_id)
+            .ok_or_else(|| {
+                anyhow!(
+                    "algorithm {} needs an external signer, pass --signature",
+                    algorithm_id
+                )
+            })?;
+        auth_builder(algorithm_type, false)
+            .map_err(|e| anyhow!("can't sign for algorithm {}: {}", algorithm_id, e))?
+    };
+    let signature = auth.sign(&auth.convert_message(&[0u8; 32]));
+    Ok((signature.to_vec(), auth.get_pub_key_hash()))
+}
+
+// Solana signs its own transaction, which can't be built here. The seed is a
+// message passing the structure checks, with as many keys as fit before the
+// blockhash, and a zero signature: whether it verifies doesn't change the
+// cycles much.
+fn solana_seed() -> (Vec<u8>, Vec<u8>) {
+    const WRAPPED_SIZE: usize = 512;
+    const KEYS: u8 = 11;
+    let mut signature = vec![0u8; WRAPPED_SIZE];
+    signature[0..2].copy_from_slice(&((WRAPPED_SIZE - 2) as u16).to_le_bytes());
+    // signature(64) | pubkey(32) | header(3) | key count(1) | keys | blockhash
+    // the ed25519 base point, a key that decompresses
+    let mut pubkey = [0x66u8; 32];
+    pubkey[0] = 0x58;
+    signature[66..98].copy_from_slice(&pubkey);
+    signature[98] = 1;
+    signature[101] = KEYS;
+    signature[102..134].copy_from_slice(&pubkey);
+    // the blockhash is the message, zeros
+    let mut pubkey_hash = vec![];
+    fix_pubkey_hash(AlgorithmType::Solana as u8, &signature, &mut pubkey_hash);
+    (signature, pubkey_hash)
+}
+
+// Where the witness carries the key, or whatever its pubkey hash covers.
+// Mutations are followed by rehashing it, otherwise nearly all of them would
+// be rejected by the pubkey hash check before reaching the expensive code.
+fn pubkey_range(algorithm_id: u8, signature: &[u8]) -> Option<Range<usize>> {
+    let range = match algorithm_id {
+        6 => 0..4 + 20 * *signature.get(3)? as usize,
+        7 => 0..32,
+        8 | 9 => {
+            let key_bytes = match signature.get(1)? {
+                1 => 128,
+                2 => 256,
+                3 => 512,
+                _ => return None,
+            };
+            0..8 + key_bytes
+        }
+        12 => 64..129,
+        13 => 66..98,
+        14 | 15 => 0..64,
+        16 => 0..48,
+        18 => 0..2 + 21 * *signature.get(1)? as usize,
+        _ => return None,
+    };
+    if range.end <= signature.len() {
+        Some(range)
+    } else {
+        None
+    }
+}
+
+fn fix_pubkey_hash(algorithm_id: u8, signature: &[u8], pubkey_hash: &mut Vec<u8>) {
+    if let Some(range) = pubkey_range(algorithm_id, signature) {
+        let hash = ckb_hash::blake2b_256(&signature[range]);
+        *pubkey_hash = hash[..20].to_vec();
+    }
+}
+
+struct Searcher {
+    algorithm_id: u8,
+    message: Vec<u8>,
+    max_cycles: u64,
+    rng: XorShift,
+    corpus: Vec<(Vec<u8>, Vec<u8>, u64)>,
+    edges: HashSet<(u64, u64)>,
+}
+
+impl Searcher {
+    // Keeps inputs that reach new edges or cost more than any before, and
+    // mutates those costing more with a higher probability.
+    fn run(
+        &mut self,
+        signature: Vec<u8>,
+        pubkey_hash: Vec<u8>,
+        iterations: u64,
+    ) -> Result<WorstCase, Error> {
+        let run = self.execute(&signature, &pubkey_hash)?;
+        self.corpus.push((signature, pubkey_hash, run.cycles));
+        let mut worst = 0;
+
+        for _ in 0..iterations {
+            let parent = self.pick();
+            let mut signature = self.corpus[parent].0.clone();
+            let mut pubkey_hash = self.corpus[parent].1.clone();
+            let rounds = 1 + self.rng.below(4);
+            for _ in 0..rounds {
+                self.mutate(&mut signature);
+            }
+            fix_pubkey_hash(self.algorithm_id, &signature, &mut pubkey_hash);
+
+            let edges_before = self.edges.len();
+            let run = self.execute(&signature, &pubkey_hash)?;
+            let worst_cycles = self.corpus[worst].2;
+            if run.cycles > worst_cycles || self.edges.len() > edges_before {
+                if run.cycles > worst_cycles {
+                    worst = self.corpus.len();
+                }
+                self.corpus.push((signature, pubkey_hash, run.cycles));
+                if self.corpus.len() > MAX_CORPUS_SIZE {
+                    worst = self.evict(worst);
+                }
+            }
+        }
+
+        let (signature, pubkey_hash, cycles) = self.corpus[worst].clone();
+        Ok(WorstCase {
+            algorithm_id: self.algorithm_id,
+            signature,
+            message: self.message.clone(),
+            pubkey_hash,
+            cycles,
+            ceiling: cycles + cycles * CEILING_MARGIN / 100,
+        })
+    }
+
+    fn execute(&mut self, signature: &[u8], pubkey_hash: &[u8]) -> Result<Run, Error> {
+        run_auth_traced(
+            self.algorithm_id,
+            signature,
+            &self.message,
+            pubkey_hash,
+            self.max_cycles,
+            &mut self.edges,
+        )
+    }
+
+    // tournament of two
+    fn pick(&mut self) -> usize {
+        let a = self.rng.below(self.corpus.len());
+        let b = self.rng.below(self.corpus.len());
+        if self.corpus[a].2 >= self.corpus[b].2 {
+            a
+        } else {
+            b
+        }
+    }
+
+    // Drops the cheapest entry but the seed and the worst one, returns the new
+    // index of the worst one.
+    fn evict(&mut self, worst: usize) -> usize {
+        let cheapest = (1..self.corpus.len())
+            .filter(|i| *i != worst)
+            .min_by_key(|i| self.corpus[*i].2)
+            .unwrap();
+        self.corpus.remove(cheapest);
+        if cheapest < worst {
+            worst - 1
+        } else {
+            worst
+        }
+    }
+
+    fn mutate(&mut self, signature: &mut Vec<u8>) {
+        const INTERESTING: [u8; 6] = [0, 1, 0x7f, 0x80, 0xfe, 0xff];
+        const INTERESTING_U16: [u16; 6] = [0, 0x7f, 0x80, 0xff, 0x7fff, 0xffff];
+        let len = signature.len();
+        match self.rng.below(8) {
+            0 if len > 0 => {
+                let i = self.rng.below(len);
+                signature[i] ^= 1 << self.rng.below(8);
+            }
+            1 if len > 0 => {
+                let i = self.rng.below(len);
+                signature[i] = INTERESTING[self.rng.below(INTERESTING.len())];
+            }
+            2 if len > 1 => {
+                let i = self.rng.below(len - 1);
+                let v = INTERESTING_U16[self.rng.below(INTERESTING_U16.len())];
+                signature[i..i + 2].copy_from_slice(&v.to_le_bytes());
+            }
+            3 if len > 0 => {
+                let i = self.rng.below(len);
+                signature[i] = self.rng.next() as u8;
+            }
+            // Repeating a chunk grows lists the validator walks, e.g. keys
+            // or CBOR items.
+            4 if len > 0 && len < MAX_SIGNATURE_SIZE => {
+                let begin = self.rng.below(len);
+                let end = (begin + 1 + self.rng.below(64)).min(len);
+                let chunk = signature[begin..end].to_vec();
+                let at = self.rng.below(len + 1);
+                signature.splice(at..at, chunk);
+            }
+            5 if len < MAX_SIGNATURE_SIZE => {
+                let at = self.rng.below(len + 1);
+                let chunk: Vec<u8> = (0..1 + self.rng.below(64))
+                    .map(|_| self.rng.next() as u8)
+                    .collect();
+                signature.splice(at..at, chunk);
+            }
+            6 if len > 1 => {
+                let begin = self.rng.below(len);
+                let end = (begin + 1 + self.rng.below(64)).min(len);
+                signature.drain(begin..end);
+            }
+            7 if self.corpus.len() > 1 => {
+                let other = &self.corpus[self.rng.below(self.corpus.len())].0;
+                let at = self.rng.below(len.min(other.len()) + 1);
+                signature.truncate(at);
+                signature.extend_from_slice(&other[at..]);
+            }
+            _ => {}
+        }
+        signature.truncate(MAX_SIGNATURE_SIZE);
+    }
+}
+
+// xorshift64*, fast and reproducible from --seed
+struct XorShift(u64);
+
+impl XorShift {
+    fn next(&mut self) -> u64 {
+        self.0 ^= self.0 >> 12;
+        self.0 ^= self.0 << 25;
+        self.0 ^= self.0 >> 27;
+        self.0.wrapping_mul(0x2545F4914F6CDD1D)
+    }
+
+    fn below(&mut self, n: usize) -> usize {
+        (self.next() % n as u64) as usize
+    }
+}
+
+pub struct Run {
+    pub cycles: u64,
+    // None when the run was cut at max_cycles
+    pub exit_code: Option<i8>,
+}
+
+// Runs build/auth with the spawn style arguments in the ckb-vm interpreter,
+// recording every taken jump or branch as a (from, to) edge. Failed runs
+// count as much as successful ones: the node pays for them either way. A run
+// cut at max_cycles reports max_cycles and no exit code.
+pub fn run_auth_traced(
+    algorithm_id: u8,
+    signature: &[u8],
+    message: &[u8],
+    pubkey_hash: &[u8],
+    max_cycles: u64,
+    edges: &mut HashSet<(u64, u64)>,
+) -> Result<Run, Error> {
+    let isa = ckb_vm::ISA_IMC | ckb_vm::ISA_B | ckb_vm::ISA_MOP;
+    let version = ckb_vm::machine::VERSION1;
+    let core =
+        DefaultCoreMachine::<u64, WXorXMemory<SparseMemory<u64>>>::new(isa, version, max_cycles);
+    let mut machine = DefaultMachineBuilder::new(core)
+        .instruction_cycle_func(Box::new(estimate_cycles))
+        .syscall(Box::new(DebugSyscall {}))
+        .syscall(Box::new(CellDepSyscall::new()))
+        .build();
+    machine
+        .load_program(
+            &AUTH_CODE,
+            &[
+                Bytes::from(format!("{:02X?}", algorithm_id)),
+                Bytes::from(encode(signature)),
+                Bytes::from(encode(message)),
+                Bytes::from(encode(pubkey_hash)),
+            ],
+        )
+        .map_err(|e| anyhow!("load build/auth: {:?}", e))?;
+
+    let mut decoder = build_decoder::<u64>(isa, version);
+    machine.set_running(true);
+    while machine.running() {
+        if machine.reset_signal() {
+            decoder.reset_instructions_cache();
+        }
+        let pc = *machine.pc();
+        match machine.step(&mut decoder) {
+            Ok(()) => {}
+            Err(ckb_vm::Error::CyclesExceeded) => {
+                return Ok(Run {
+                    cycles: max_cycles,
+                    exit_code: None,
+                })
+            }
+            Err(e) => return Err(anyhow!("run build/auth: {:?}", e)),
+        }
+        let next = *machine.pc();
+        if next != pc + 2 && next != pc + 4 {
+            edges.insert((pc, next));
+        }
+    }
+    Ok(Run {
+        cycles: machine.cycles(),
+        exit_code: Some(machine.exit_code()),
+    })
+}
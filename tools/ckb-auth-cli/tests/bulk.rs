@@ -0,0 +1,76 @@
+// Runs `ckb-auth-cli bulk-generate` and replays what it wrote, build
+// build/auth first with `make all BLS=1` in the repository root.
+use std::process::Command;
+
+fn cli(args: &[&str]) -> bool {
+    Command::new(env!("CARGO_BIN_EXE_ckb-auth-cli"))
+        .args(args)
+        .status()
+        .expect("run ckb-auth-cli")
+        .success()
+}
+
+#[test]
+fn bulk_generate_and_replay() {
+    let base = std::env::temp_dir().join(format!("ckb-auth-bulk-{}", std::process::id()));
+    let dir = base.join("txs");
+    let dir = dir.to_str().unwrap();
+    let baseline = base.join("baseline.json");
+    let baseline = baseline.to_str().unwrap();
+
+    // 2 lock groups of 2 inputs, cycling through secp256k1, multisig and
+    // Ethereum on 3 threads
+    assert!(cli(&[
+        "bulk-generate",
+        "--count",
+        "8",
+        "--algorithm",
+        "0",
+        "--algorithm",
+        "6",
+        "--algorithm",
+        "1",
+        "--groups",
+        "2",
+        "--inputs",
+        "2",
+        "--multisig",
+        "1-of-2",
+        "--threads",
+        "3",
+        "--dir",
+        dir,
+    ]));
+    let count = std::fs::read_dir(dir).unwrap().count();
+    assert_eq!(count, 8);
+    assert!(cli(&[
+        "replay",
+        "run",
+        "--dir",
+        dir,
+        "--baseline",
+        baseline,
+        "--save"
+    ]));
+
+    // Solana needs its own client to sign
+    assert!(!cli(&[
+        "bulk-generate",
+        "--count",
+        "1",
+        "--algorithm",
+        "13",
+        "--dir",
+        dir
+    ]));
+    assert!(!cli(&[
+        "bulk-generate",
+        "--count",
+        "1",
+        "--multisig",
+        "3-of-2",
+        "--dir",
+        dir
+    ]));
+    std::fs::remove_dir_all(&base).unwrap();
+}
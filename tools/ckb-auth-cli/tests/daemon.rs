@@ -0,0 +1,225 @@
+// Runs `ckb-auth-cli daemon` against build/auth, build it first with
+// `make all BLS=1` in the repository root.
+use ckb_auth_rs::{auth_builder, AlgorithmType};
+use std::io::{Read, Write};
+use std::os::unix::net::UnixStream;
+use std::path::PathBuf;
+use std::process::{Child, Command};
+use std::thread;
+use std::time::{Duration, Instant};
+
+struct Daemon {
+    child: Child,
+    socket: PathBuf,
+}
+
+impl Daemon {
+    fn start(name: &str, threads: usize) -> Daemon {
+        let socket = std::env::temp_dir().join(format!(
+            "ckb-auth-daemon-{}-{}.sock",
+            name,
+            std::process::id()
+        ));
+        let child = Command::new(env!("CARGO_BIN_EXE_ckb-auth-cli"))
+            .arg("daemon")
+            .arg("--socket")
+            .arg(&socket)
+            .arg("--threads")
+            .arg(threads.to_string())
+            .spawn()
+            .expect("start daemon");
+        let daemon = Daemon { child, socket };
+        for _ in 0..100 {
+            if UnixStream::connect(&daemon.socket).is_ok() {
+                return daemon;
+            }
+            thread::sleep(Duration::from_millis(50));
+        }
+        panic!("daemon didn't listen on {:?}", daemon.socket);
+    }
+
+    fn connect(&self) -> UnixStream {
+        UnixStream::connect(&self.socket).expect("connect daemon")
+    }
+}
+
+impl Drop for Daemon {
+    fn drop(&mut self) {
+        let _ = self.child.kill();
+        let _ = self.child.wait();
+        let _ = std::fs::remove_file(&self.socket);
+    }
+}
+
+#[derive(Clone)]
+struct Signed {
+    algorithm_id: u8,
+    pubkey_hash: Vec<u8>,
+    message: Vec<u8>,
+    signature: Vec<u8>,
+}
+
+fn sign(algorithm_type: AlgorithmType, message: [u8; 32]) -> Signed {
+    let auth = auth_builder(algorithm_type, false).unwrap();
+    let signature = auth.sign(&auth.convert_message(&message));
+    Signed {
+        algorithm_id: auth.get_algorithm_type(),
+        pubkey_hash: auth.get_pub_key_hash(),
+        message: message.to_vec(),
+        signature: signature.to_vec(),
+    }
+}
+
+fn write_request(stream: &mut UnixStream, id: u32, signed: &Signed) {
+    let mut body = id.to_le_bytes().to_vec();
+    body.push(signed.algorithm_id);
+    body.extend_from_slice(&signed.pubkey_hash);
+    body.extend_from_slice(&(signed.message.len() as u16).to_le_bytes());
+    body.extend_from_slice(&signed.message);
+    body.extend_from_slice(&signed.signature);
+    let mut frame = (body.len() as u32).to_le_bytes().to_vec();
+    frame.extend_from_slice(&body);
+    stream.write_all(&frame).expect("write request");
+}
+
+// (request id, code, cached)
+fn read_response(stream: &mut UnixStream) -> (u32, i32, bool) {
+    let mut response = [0u8; 9];
+    stream.read_exact(&mut response).expect("read response");
+    (
+        u32::from_le_bytes(response[0..4].try_into().unwrap()),
+        i32::from_le_bytes(response[4..8].try_into().unwrap()),
+        response[8] != 0,
+    )
+}
+
+#[test]
+fn daemon_verify() {
+    let daemon = Daemon::start("verify", 2);
+    let mut stream = daemon.connect();
+    let signed = sign(AlgorithmType::Bls12381, [1u8; 32]);
+
+    write_request(&mut stream, 1, &signed);
+    assert_eq!(read_response(&mut stream), (1, 0, false));
+    write_request(&mut stream, 2, &signed);
+    assert_eq!(read_response(&mut stream), (2, 0, true));
+
+    let mut tampered = signed.clone();
+    tampered.message[0] ^= 1;
+    write_request(&mut stream, 3, &tampered);
+    let (id, code, cached) = read_response(&mut stream);
+    assert_eq!((id, cached), (3, false));
+    assert_ne!(code, 0);
+    // failures are remembered too
+    write_request(&mut stream, 4, &tampered);
+    assert_eq!(read_response(&mut stream), (4, code, true));
+}
+
+// The secp256k1 and secp256r1 based algorithms load their tables from cell deps
+#[test]
+fn daemon_cell_deps() {
+    let daemon = Daemon::start("cell-deps", 2);
+    let mut stream = daemon.connect();
+    let algorithms = [
+        AlgorithmType::Ckb,
+        AlgorithmType::Ethereum,
+        AlgorithmType::Bitcoin,
+        AlgorithmType::Secp256r1,
+    ];
+    for (i, algorithm_type) in algorithms.into_iter().enumerate() {
+        write_request(&mut stream, i as u32, &sign(algorithm_type, [2u8; 32]));
+        assert_eq!(read_response(&mut stream), (i as u32, 0, false));
+    }
+}
+
+#[test]
+fn daemon_pipelined() {
+    let daemon = Daemon::start("pipelined", 4);
+    let mut stream = daemon.connect();
+    let requests: Vec<Signed> = (0..16u8)
+        .map(|i| sign(AlgorithmType::Bls12381, [i; 32]))
+        .collect();
+    for (i, signed) in requests.iter().enumerate() {
+        write_request(&mut stream, i as u32, signed);
+    }
+    let mut ids: Vec<u32> = (0..requests.len())
+        .map(|_| {
+            let (id, code, _) = read_response(&mut stream);
+            assert_eq!(code, 0);
+            id
+        })
+        .collect();
+    ids.sort();
+    assert_eq!(ids, (0..requests.len() as u32).collect::<Vec<_>>());
+}
+
+// Load generator: CLIENTS connections each send REQUESTS requests one at a
+// time, picked from UNIQUE signed entries, so that most of them are served
+// from the cache as they would be for re-broadcast transactions. Run with
+// `cargo test --release daemon_load -- --nocapture` to see the percentiles.
+#[test]
+fn daemon_load() {
+    const CLIENTS: usize = 8;
+    const REQUESTS: usize = 200;
+    const UNIQUE: usize = 64;
+
+    let daemon = Daemon::start("load", 4);
+    let algorithms = [
+        AlgorithmType::Bls12381,
+        AlgorithmType::RSA,
+        AlgorithmType::Iso9796_2,
+        AlgorithmType::HashPreimage,
+    ];
+    let entries: Vec<Signed> = (0..UNIQUE)
+        .map(|i| sign(algorithms[i % algorithms.len()], [i as u8; 32]))
+        .collect();
+
+    let start = Instant::now();
+    let clients: Vec<_> = (0..CLIENTS)
+        .map(|c| {
+            let mut stream = daemon.connect();
+            let entries = entries.clone();
+            thread::spawn(move || {
+                let mut latencies = Vec::with_capacity(REQUESTS);
+                let mut cached_count = 0;
+                for r in 0..REQUESTS {
+                    let signed = &entries[(c * 7 + r) % entries.len()];
+                    let begin = Instant::now();
+                    write_request(&mut stream, r as u32, signed);
+                    let (id, code, cached) = read_response(&mut stream);
+                    latencies.push(begin.elapsed());
+                    assert_eq!((id, code), (r as u32, 0));
+                    cached_count += cached as usize;
+                }
+                (latencies, cached_count)
+            })
+        })
+        .collect();
+
+    let mut latencies = vec![];
+    let mut cached_count = 0;
+    for client in clients {
+        let (l, c) = client.join().unwrap();
+        latencies.extend(l);
+        cached_count += c;
+    }
+    let elapsed = start.elapsed();
+    latencies.sort();
+    let percentile = |p: usize| latencies[(latencies.len() - 1) * p / 100];
+    println!(
+        "{} requests from {} clients in {:?}, {:.0} requests/s, {} cached",
+        latencies.len(),
+        CLIENTS,
+        elapsed,
+        latencies.len() as f64 / elapsed.as_secs_f64(),
+        cached_count
+    );
+    println!(
+        "latency p50 {:?} p90 {:?} p99 {:?} max {:?}",
+        percentile(50),
+        percentile(90),
+        percentile(99),
+        percentile(100)
+    );
+    assert!(cached_count >= CLIENTS * REQUESTS - UNIQUE * CLIENTS);
+}
@@ -0,0 +1,86 @@
+// Unit tests of the calibration table lookup, no build/auth needed.
+use ckb_auth_cli::estimate::{estimate_cycles, CyclesSample};
+
+const ALGORITHM_ID: u8 = 16;
+const ENTRY_CATEGORY: u8 = 1;
+
+fn table(points: &[(usize, u64)]) -> Vec<CyclesSample> {
+    let mut table: Vec<CyclesSample> = points
+        .iter()
+        .map(|(signature_size, cycles)| CyclesSample {
+            algorithm_id: ALGORITHM_ID,
+            entry_category: ENTRY_CATEGORY,
+            signature_size: *signature_size,
+            cycles: *cycles,
+        })
+        .collect();
+    // samples of other algorithms and categories must be ignored
+    table.push(CyclesSample {
+        algorithm_id: ALGORITHM_ID + 1,
+        entry_category: ENTRY_CATEGORY,
+        signature_size: 150,
+        cycles: 1,
+    });
+    table.push(CyclesSample {
+        algorithm_id: ALGORITHM_ID,
+        entry_category: ENTRY_CATEGORY + 1,
+        signature_size: 150,
+        cycles: 1,
+    });
+    table
+}
+
+fn estimate(table: &[CyclesSample], signature_size: usize) -> u64 {
+    estimate_cycles(table, ALGORITHM_ID, ENTRY_CATEGORY, signature_size).unwrap()
+}
+
+#[test]
+fn exact_hit() {
+    let t = table(&[(100, 1000), (200, 2000), (400, 3000)]);
+    assert_eq!(estimate(&t, 100), 1000);
+    assert_eq!(estimate(&t, 200), 2000);
+    assert_eq!(estimate(&t, 400), 3000);
+}
+
+#[test]
+fn interpolation() {
+    let t = table(&[(400, 3000), (100, 1000), (200, 2000)]);
+    assert_eq!(estimate(&t, 150), 1500);
+    assert_eq!(estimate(&t, 300), 2500);
+    // rounded up
+    assert_eq!(estimate(&t, 101), 1010);
+    let t = table(&[(0, 0), (3, 1)]);
+    assert_eq!(estimate(&t, 1), 1);
+}
+
+#[test]
+fn extrapolation() {
+    let t = table(&[(100, 1000), (200, 2000), (400, 3000)]);
+    // above: from the last two samples
+    assert_eq!(estimate(&t, 600), 4000);
+    // below: the smallest sample, not extrapolated down
+    assert_eq!(estimate(&t, 50), 1000);
+    let t = table(&[(100, 1000), (200, 5000)]);
+    assert_eq!(estimate(&t, 0), 1000);
+}
+
+#[test]
+fn single_sample() {
+    let t = table(&[(100, 1000)]);
+    assert_eq!(estimate(&t, 10), 1000);
+    assert_eq!(estimate(&t, 1000), 1000);
+}
+
+#[test]
+fn repeated_sizes_keep_the_highest() {
+    let t = table(&[(100, 1000), (100, 1200), (200, 2000), (100, 1100)]);
+    assert_eq!(estimate(&t, 100), 1200);
+    assert_eq!(estimate(&t, 150), 1600);
+}
+
+#[test]
+fn no_samples() {
+    let t = table(&[(100, 1000)]);
+    assert!(estimate_cycles(&t, ALGORITHM_ID + 2, ENTRY_CATEGORY, 100).is_err());
+    assert!(estimate_cycles(&[], ALGORITHM_ID, ENTRY_CATEGORY, 100).is_err());
+}
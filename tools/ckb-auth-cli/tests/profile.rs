@@ -0,0 +1,60 @@
+// Runs `ckb-auth-cli profile` against build/auth and build/auth.debug, build
+// them first with `make all BLS=1` in the repository root.
+use std::process::Command;
+
+// (sum of the profile's cycles, cycles of the run)
+fn profile(algorithm_id: u8, flat: bool) -> (u64, u64) {
+    let mut args = vec![
+        "profile".to_string(),
+        "-a".to_string(),
+        algorithm_id.to_string(),
+    ];
+    if flat {
+        args.push("--flat".to_string());
+    }
+    let output = Command::new(env!("CARGO_BIN_EXE_ckb-auth-cli"))
+        .args(&args)
+        .current_dir("../..")
+        .output()
+        .expect("run profile");
+    assert!(
+        output.status.success(),
+        "profile algorithm {}: {}",
+        algorithm_id,
+        String::from_utf8_lossy(&output.stderr)
+    );
+
+    // folded stacks end with their cycles, flat lines start with them
+    let stdout = String::from_utf8(output.stdout).unwrap();
+    let sum = stdout
+        .lines()
+        .map(|line| {
+            let field = if flat {
+                line.split_whitespace().next()
+            } else {
+                line.rsplit(' ').next()
+            };
+            field.unwrap().parse::<u64>().unwrap()
+        })
+        .sum();
+    let stderr = String::from_utf8(output.stderr).unwrap();
+    let total = stderr
+        .lines()
+        .find_map(|line| line.strip_suffix(" cycles"))
+        .expect("total cycles")
+        .parse::<u64>()
+        .unwrap();
+    (sum, total)
+}
+
+#[test]
+fn profile_adds_up_to_the_run() {
+    // Ethereum and secp256r1 read their tables from cell deps
+    for algorithm_id in [1, 14] {
+        for flat in [false, true] {
+            let (sum, total) = profile(algorithm_id, flat);
+            assert!(total > 0);
+            assert_eq!(sum, total, "algorithm {} flat {}", algorithm_id, flat);
+        }
+    }
+}
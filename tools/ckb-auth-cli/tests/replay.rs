@@ -0,0 +1,52 @@
+// Runs `ckb-auth-cli replay` against build/auth, build it first with
+// `make all BLS=1` in the repository root.
+use std::process::Command;
+
+fn replay(args: &[&str]) -> bool {
+    Command::new(env!("CARGO_BIN_EXE_ckb-auth-cli"))
+        .arg("replay")
+        .args(args)
+        .status()
+        .expect("run replay")
+        .success()
+}
+
+#[test]
+fn replay_corpus() {
+    let base = std::env::temp_dir().join(format!("ckb-auth-replay-{}", std::process::id()));
+    let dir = base.join("corpus");
+    let dir = dir.to_str().unwrap();
+    let baseline = base.join("baseline.json");
+    let baseline = baseline.to_str().unwrap();
+
+    assert!(replay(&["corpus", "--dir", dir]));
+    assert!(replay(&[
+        "run",
+        "--dir",
+        dir,
+        "--baseline",
+        baseline,
+        "--save"
+    ]));
+    // replaying the same transactions costs the same cycles
+    assert!(replay(&[
+        "run",
+        "--dir",
+        dir,
+        "--baseline",
+        baseline,
+        "--tolerance",
+        "0"
+    ]));
+
+    // a baseline below the replayed cycles fails the run
+    let content = std::fs::read_to_string(baseline).unwrap();
+    let mut value: serde_json::Value = serde_json::from_str(&content).unwrap();
+    for entry in value.as_object_mut().unwrap().values_mut() {
+        let total = entry["total"].as_u64().unwrap();
+        entry["total"] = serde_json::json!(total / 2);
+    }
+    std::fs::write(baseline, value.to_string()).unwrap();
+    assert!(!replay(&["run", "--dir", dir, "--baseline", baseline]));
+    let _ = std::fs::remove_dir_all(&base);
+}
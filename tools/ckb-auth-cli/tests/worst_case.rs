@@ -0,0 +1,33 @@
+// Runs `ckb-auth-cli worst-case` against build/auth, build it first with
+// `make all BLS=1` in the repository root.
+use std::path::Path;
+use std::process::Command;
+
+fn worst_case(args: &[&str]) -> bool {
+    Command::new(env!("CARGO_BIN_EXE_ckb-auth-cli"))
+        .arg("worst-case")
+        .args(args)
+        .status()
+        .expect("run worst-case")
+        .success()
+}
+
+#[test]
+fn worst_case_search() {
+    let record = std::env::temp_dir().join(format!("ckb-auth-worst-{}.json", std::process::id()));
+    let record = record.to_str().unwrap();
+    for algorithm in ["17", "16"] {
+        assert!(worst_case(&[
+            "search",
+            "--algorithm",
+            algorithm,
+            "--iterations",
+            "200",
+            "--record",
+            record,
+        ]));
+    }
+    assert!(Path::new(record).exists());
+    assert!(worst_case(&["check", "--record", record]));
+    let _ = std::fs::remove_file(record);
+}